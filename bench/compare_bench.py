@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Compare two JSON reports of search_bench and flag regressions
+# Usage: compare_bench.py baseline.json current.json [--threshold 0.10]
+# A benchmark regresses if its p50 or p99 latency grew or its throughput fell by more than the threshold,
+# memory regresses if peak RSS or the size of the index (all of it or the positional index) grew by more than the threshold
+# Exit code is 1 if there is a regression, so the script can be used in CI
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        report = json.load(file)
+    return report, {benchmark["name"]: benchmark for benchmark in report["benchmarks"]}
+
+
+def change(baseline, current):
+    return (current - baseline) / baseline if baseline else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare reports of search_bench")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed relative change (default 0.10)")
+    args = parser.parse_args()
+
+    baseline_report, baseline = load(args.baseline)
+    current_report, current = load(args.current)
+    if (baseline_report["scale"], baseline_report["seed"]) != (current_report["scale"], current_report["seed"]):
+        print("Warning: reports are made for different corpora", file=sys.stderr)
+
+    regressions = []
+    print(f"{'benchmark':<24} {'p50':>9} {'p99':>9} {'throughput':>11}")
+    for name, old in baseline.items():
+        new = current.get(name)
+        if new is None:
+            print(f"{name:<24} missing in {args.current}")
+            continue
+
+        p50 = change(old["p50_ns"], new["p50_ns"])
+        p99 = change(old["p99_ns"], new["p99_ns"])
+        throughput = change(old["throughput_per_s"], new["throughput_per_s"])
+        is_regression = p50 > args.threshold or p99 > args.threshold or throughput < -args.threshold
+        if is_regression:
+            regressions.append(name)
+        print(f"{name:<24} {p50:>+9.1%} {p99:>+9.1%} {throughput:>+11.1%}{'  REGRESSION' if is_regression else ''}")
+
+    # Memory: peak RSS of the run and the index of the corpus (older reports have no index fields)
+    for key in ("peak_rss_kb", "index_bytes", "positional_index_bytes"):
+        if key not in baseline_report or key not in current_report:
+            continue
+        growth = change(baseline_report[key], current_report[key])
+        print(f"{key:<24} {growth:>+9.1%}{'  REGRESSION' if growth > args.threshold else ''}")
+        if growth > args.threshold:
+            regressions.append(key)
+
+    if regressions:
+        print(f"Regressions: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,460 @@
+// search_bench - benchmarks of the search server on reproducible corpora
+// Usage: search_bench [--scale small|medium|large] [--seed N] [--output file.json]
+// Scales: small - 10k documents, medium - 1M documents, large - 10M documents
+// Words of documents and queries follow Zipf's law. Random numbers are produced by mt19937_64 and own distributions,
+// so the corpus is the same for the same seed on every platform and standard library
+// Result is JSON with p50/p99 latency, throughput and growth of RSS of every benchmark and peak RSS of the process,
+// results of two runs are compared by compare_bench.py
+
+#include "index_memory_resource.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct BenchConfig {
+    string scale = "small"s;
+    uint64_t seed = 42;
+    string output;
+
+    size_t document_count = 10'000;
+    size_t vocabulary_size = 50'000;
+    size_t query_count = 1'000;
+    size_t duplicate_corpus_size = 10'000;
+};
+
+struct BenchResult {
+    string name;
+    size_t operations = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    double throughput_per_s = 0;
+    long rss_growth_kb = 0;
+};
+
+// Memory of the index of the whole corpus (SearchServer::GetMemoryStats): positions for phrase queries
+// are stored by default (SearchServerOptions::use_positional_index), so their share is reported apart
+struct IndexMemory {
+    size_t total_bytes = 0;
+    size_t positional_index_bytes = 0;
+    size_t positions = 0;
+};
+
+struct BenchReport {
+    vector<BenchResult> results;
+    IndexMemory index_memory;
+};
+
+// ------------------------------- Reproducible random ------------------------------- //
+
+// Uniform integer in [0, bound) (without std distributions, which differ between standard libraries)
+uint64_t UniformInt(mt19937_64& generator, uint64_t bound) {
+    return static_cast<uint64_t>((generator() >> 11) * 0x1.0p-53 * bound);
+}
+
+// Zipf distribution over ranks [0, size) with exponent s: P(rank) ~ 1 / (rank + 1)^s
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t size, double exponent) {
+        cdf_.reserve(size);
+        double sum = 0;
+        for (size_t rank = 0; rank < size; ++rank) {
+            sum += 1.0 / pow(rank + 1.0, exponent);
+            cdf_.push_back(sum);
+        }
+        for (double& value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    size_t operator()(mt19937_64& generator) const {
+        const double value = (generator() >> 11) * 0x1.0p-53;
+        return min<size_t>(lower_bound(cdf_.begin(), cdf_.end(), value) - cdf_.begin(), cdf_.size() - 1);
+    }
+
+private:
+    vector<double> cdf_;
+};
+
+// Word of the rank: different ranks give different words of 3..12 letters
+string MakeWord(size_t rank) {
+    uint64_t hash = rank * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull;
+    string word;
+    const size_t length = 3 + hash % 10;
+    for (size_t i = 0; i < length; ++i) {
+        hash = hash * 6364136223846793005ull + 1442695040888963407ull;
+        word.push_back(static_cast<char>('a' + (hash >> 33) % 26));
+    }
+    // Suffix makes words of different ranks different
+    for (size_t value = rank; value > 0; value /= 26) {
+        word.push_back(static_cast<char>('a' + value % 26));
+    }
+    return word;
+}
+
+class CorpusGenerator {
+public:
+    CorpusGenerator(const BenchConfig& config)
+        : generator_(config.seed), zipf_(config.vocabulary_size, 1.07) {
+        words_.reserve(config.vocabulary_size);
+        for (size_t rank = 0; rank < config.vocabulary_size; ++rank) {
+            words_.push_back(MakeWord(rank));
+        }
+    }
+
+    string GenerateDocument() {
+        const size_t word_count = 20 + UniformInt(generator_, 81);
+        string document;
+        for (size_t i = 0; i < word_count; ++i) {
+            document += (document.empty() ? ""s : " "s) + words_[zipf_(generator_)];
+        }
+        return document;
+    }
+
+    // Query of 1..4 words, every word after the first one is a minus-word with probability minus_prob
+    string GenerateQuery(double minus_prob = 0.1) {
+        const size_t word_count = 1 + UniformInt(generator_, 4);
+        string query;
+        for (size_t i = 0; i < word_count; ++i) {
+            if (!query.empty()) {
+                query.push_back(' ');
+                if (UniformInt(generator_, 1000) < minus_prob * 1000) {
+                    query.push_back('-');
+                }
+            }
+            query += words_[zipf_(generator_)];
+        }
+        return query;
+    }
+
+    // Prefix query (serv*): first 2..4 letters of a word with the suffix *
+    // Drawn from a separate generator, so the other inputs stay the same as without these queries
+    string GeneratePrefixQuery(mt19937_64& generator) const {
+        const string& word = words_[zipf_(generator)];
+        return word.substr(0, 2 + UniformInt(generator, 3)) + "*"s;
+    }
+
+    // Fuzzy query (word~ or word~2): a word with one letter replaced, a third of them with distance 2
+    string GenerateFuzzyQuery(mt19937_64& generator) const {
+        string word = words_[zipf_(generator)];
+        word[UniformInt(generator, word.size())] = static_cast<char>('a' + UniformInt(generator, 26));
+        return word + (UniformInt(generator, 3) == 0 ? "~2"s : "~"s);
+    }
+
+    vector<int> GenerateRatings() {
+        vector<int> ratings(1 + UniformInt(generator_, 5));
+        for (int& rating : ratings) {
+            rating = static_cast<int>(UniformInt(generator_, 21)) - 10;
+        }
+        return ratings;
+    }
+
+    uint64_t GenerateIndex(uint64_t bound) {
+        return UniformInt(generator_, bound);
+    }
+
+private:
+    mt19937_64 generator_;
+    ZipfGenerator zipf_;
+    vector<string> words_;
+};
+
+// ------------------------------- Measuring ------------------------------- //
+
+uint64_t Percentile(vector<uint64_t> latencies, double quantile) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    const size_t index = min(static_cast<size_t>(quantile * latencies.size()), latencies.size() - 1);
+    nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+// Current resident set size of the process in kilobytes (0 where /proc is not available)
+long GetCurrentRssKb() {
+    ifstream statm("/proc/self/statm"s);
+    long total_pages = 0;
+    long resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Call operation(i) for i in [0, count) and measure every call
+BenchResult Measure(const string& name, size_t count, const function<void(size_t)>& operation) {
+    vector<uint64_t> latencies;
+    latencies.reserve(count);
+    const long start_rss_kb = GetCurrentRssKb();
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const Clock::time_point operation_start = Clock::now();
+        operation(i);
+        latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - operation_start).count());
+    }
+    const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    BenchResult result;
+    result.name = name;
+    result.operations = count;
+    result.p50_ns = Percentile(latencies, 0.5);
+    result.p99_ns = Percentile(latencies, 0.99);
+    result.throughput_per_s = seconds > 0 ? count / seconds : 0;
+    result.rss_growth_kb = GetCurrentRssKb() - start_rss_kb;
+    cerr << name << ": p50 "s << result.p50_ns << " ns, p99 "s << result.p99_ns << " ns, "s
+         << result.throughput_per_s << " ops/s, RSS "s << showpos << result.rss_growth_kb << noshowpos << " kB"s << endl;
+    return result;
+}
+
+// Peak resident set size of the process in kilobytes
+long GetPeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// ------------------------------- Benchmarks ------------------------------- //
+
+BenchReport RunBenchmarks(const BenchConfig& config) {
+    BenchReport report;
+    vector<BenchResult>& results = report.results;
+    CorpusGenerator corpus(config);
+
+    vector<string> documents;
+    vector<vector<int>> ratings;
+    documents.reserve(config.document_count);
+    for (size_t i = 0; i < config.document_count; ++i) {
+        documents.push_back(corpus.GenerateDocument());
+        ratings.push_back(corpus.GenerateRatings());
+    }
+    vector<string> queries;
+    for (size_t i = 0; i < config.query_count; ++i) {
+        queries.push_back(corpus.GenerateQuery());
+    }
+    mt19937_64 expansion_generator(config.seed + 1);
+    vector<string> prefix_queries;
+    vector<string> fuzzy_queries;
+    for (size_t i = 0; i < config.query_count; ++i) {
+        prefix_queries.push_back(corpus.GeneratePrefixQuery(expansion_generator));
+        fuzzy_queries.push_back(corpus.GenerateFuzzyQuery(expansion_generator));
+    }
+
+    // Ingest of the whole corpus: every call is measured, throughput is documents per second
+    SearchServer search_server("a the and"s);
+    results.push_back(Measure("add_document"s, documents.size(), [&](size_t i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, ratings[i]);
+    }));
+    const PositionalIndex::MemoryUsage positional_memory = search_server.GetPositionalIndexMemoryUsage();
+    report.index_memory = {search_server.GetMemoryStats().GetTotal(), positional_memory.total_bytes, positional_memory.position_count};
+
+    // Bulk ingest into a new server without measuring every call and destruction of the server,
+    // with nodes of the index from the global allocator and from IndexMemoryResource
+    for (const bool use_pool : {false, true}) {
+        const size_t bulk_count = min<size_t>(documents.size(), 100'000);
+        const string suffix = use_pool ? "_pool"s : ""s;
+        auto pool = make_unique<IndexMemoryResource>();
+        SearchServerOptions options;
+        options.memory_resource = use_pool ? pool.get() : nullptr;
+        auto bulk_server = make_unique<SearchServer>("a the and"s, options);
+        results.push_back(Measure("bulk_ingest"s + suffix, 1, [&](size_t) {
+            for (size_t i = 0; i < bulk_count; ++i) {
+                bulk_server->AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, ratings[i]);
+            }
+        }));
+        results.back().throughput_per_s *= bulk_count;
+        results.push_back(Measure("destroy_index"s + suffix, 1, [&](size_t) {
+            bulk_server.reset();
+            pool.reset();
+        }));
+        results.back().throughput_per_s *= bulk_count;
+    }
+
+    results.push_back(Measure("find_top_documents_seq"s, queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(execution::seq, queries[i]);
+    }));
+    results.push_back(Measure("find_top_documents_par"s, queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(execution::par, queries[i]);
+    }));
+
+    // Expansion of prefixes through the term dictionary and of fuzzy words by the Levenshtein automaton
+    results.push_back(Measure("prefix_query"s, prefix_queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(prefix_queries[i]);
+    }));
+    results.push_back(Measure("fuzzy_query"s, fuzzy_queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(fuzzy_queries[i]);
+    }));
+
+    // Selection of the top of many found documents by packed sort keys: throughput is documents per second
+    {
+        vector<Document> found_documents;
+        for (size_t i = 0; i < documents.size(); ++i) {
+            found_documents.push_back({static_cast<int>(i), static_cast<double>(i * 2'654'435'761u % 1'000'000) / 1e5, static_cast<int>(i % 10)});
+        }
+        vector<Document> top;
+        results.push_back(Measure("keep_top_documents"s, queries.size(), [&](size_t) {
+            top = found_documents;
+            KeepTopDocuments(top, MAX_RESULT_DOCUMENT_COUNT);
+        }));
+        results.back().throughput_per_s *= found_documents.size();
+    }
+
+    vector<int> match_documents;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        match_documents.push_back(static_cast<int>(corpus.GenerateIndex(documents.size())));
+    }
+    results.push_back(Measure("match_document"s, queries.size(), [&](size_t i) {
+        search_server.MatchDocument(queries[i], match_documents[i]);
+    }));
+
+    // Highlighting of a page of 50 results: throughput is documents per second
+    const size_t page_size = 50;
+    vector<int> page(page_size);
+    results.push_back(Measure("match_documents_page"s, queries.size(), [&](size_t i) {
+        for (size_t j = 0; j < page_size; ++j) {
+            page[j] = match_documents[(i + j) % match_documents.size()];
+        }
+        search_server.MatchDocuments(queries[i], page);
+    }));
+    results.back().throughput_per_s *= page_size;
+
+    // Batches of queries: throughput is queries per second
+    const size_t batch_count = 10;
+    results.push_back(Measure("process_queries"s, batch_count, [&](size_t) {
+        ProcessQueries(search_server, queries);
+    }));
+    results.back().throughput_per_s *= queries.size();
+
+    // Duplicates: a separate corpus where every 10th document repeats an earlier one
+    {
+        SearchServer duplicate_server("a the and"s);
+        const size_t duplicate_count = min(config.duplicate_corpus_size, documents.size());
+        for (size_t i = 0; i < duplicate_count; ++i) {
+            const size_t source = i % 10 == 9 ? corpus.GenerateIndex(i) : i;
+            duplicate_server.AddDocument(static_cast<int>(i), documents[source], DocumentStatus::ACTUAL, ratings[i]);
+        }
+        // RemoveDuplicates reports removed documents to cout
+        ostringstream removed_report;
+        streambuf* const cout_buffer = cout.rdbuf(removed_report.rdbuf());
+        results.push_back(Measure("remove_duplicates"s, 1, [&](size_t) {
+            RemoveDuplicates(duplicate_server);
+        }));
+        cout.rdbuf(cout_buffer);
+        results.back().throughput_per_s *= duplicate_count;
+    }
+
+    // Removing is the last benchmark, it changes the server
+    const size_t remove_count = min<size_t>(documents.size() / 10, 10'000);
+    results.push_back(Measure("remove_document"s, remove_count, [&](size_t i) {
+        search_server.RemoveDocument(static_cast<int>(i * 10));
+    }));
+
+    // Removing by batches of other documents: throughput is documents per second
+    const size_t remove_batch_size = 1'000;
+    vector<vector<int>> remove_batches((remove_count + remove_batch_size - 1) / remove_batch_size);
+    for (size_t i = 0; i < remove_count; ++i) {
+        remove_batches[i / remove_batch_size].push_back(static_cast<int>(i * 10 + 5));
+    }
+    results.push_back(Measure("remove_documents"s, remove_batches.size(), [&](size_t i) {
+        search_server.RemoveDocuments(execution::par, remove_batches[i]);
+    }));
+    results.back().throughput_per_s *= static_cast<double>(remove_count) / max<size_t>(remove_batches.size(), 1);
+
+    return report;
+}
+
+// ------------------------------- Report ------------------------------- //
+
+void WriteJson(ostream& out, const BenchConfig& config, const BenchReport& report) {
+    const vector<BenchResult>& results = report.results;
+    out << "{\n"s;
+    out << "  \"scale\": \""s << config.scale << "\",\n"s;
+    out << "  \"seed\": "s << config.seed << ",\n"s;
+    out << "  \"documents\": "s << config.document_count << ",\n"s;
+    out << "  \"queries\": "s << config.query_count << ",\n"s;
+    out << "  \"peak_rss_kb\": "s << GetPeakRssKb() << ",\n"s;
+    out << "  \"index_bytes\": "s << report.index_memory.total_bytes << ",\n"s;
+    out << "  \"positional_index_bytes\": "s << report.index_memory.positional_index_bytes << ",\n"s;
+    out << "  \"positions\": "s << report.index_memory.positions << ",\n"s;
+    out << "  \"benchmarks\": [\n"s;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        out << "    {\"name\": \""s << result.name << "\", \"operations\": "s << result.operations
+            << ", \"p50_ns\": "s << result.p50_ns << ", \"p99_ns\": "s << result.p99_ns
+            << ", \"throughput_per_s\": "s << static_cast<uint64_t>(result.throughput_per_s)
+            << ", \"rss_growth_kb\": "s << result.rss_growth_kb << "}"s
+            << (i + 1 < results.size() ? ",\n"s : "\n"s);
+    }
+    out << "  ]\n"s;
+    out << "}\n"s;
+}
+
+BenchConfig ParseArguments(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const string argument = argv[i];
+        if (i + 1 == argc) {
+            throw invalid_argument("No value for "s + argument);
+        }
+        const string value = argv[++i];
+        if (argument == "--scale"s) {
+            config.scale = value;
+        } else if (argument == "--seed"s) {
+            config.seed = stoull(value);
+        } else if (argument == "--output"s) {
+            config.output = value;
+        } else {
+            throw invalid_argument("Unknown argument "s + argument);
+        }
+    }
+
+    if (config.scale == "small"s) {
+        config.document_count = 10'000;
+        config.vocabulary_size = 50'000;
+    } else if (config.scale == "medium"s) {
+        config.document_count = 1'000'000;
+        config.vocabulary_size = 500'000;
+    } else if (config.scale == "large"s) {
+        config.document_count = 10'000'000;
+        config.vocabulary_size = 2'000'000;
+    } else {
+        throw invalid_argument("Unknown scale "s + config.scale);
+    }
+    return config;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchConfig config = ParseArguments(argc, argv);
+        const BenchReport report = RunBenchmarks(config);
+        if (config.output.empty()) {
+            WriteJson(cout, config, report);
+        } else {
+            ofstream out(config.output);
+            WriteJson(out, config, report);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: "s << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
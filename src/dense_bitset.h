@@ -0,0 +1,42 @@
+#pragma once
+
+// DenseBitset - bit per internal number of a document, grows on demand
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class DenseBitset
+{
+public:
+    void Set(size_t index)
+    {
+        if (index / 64 >= words_.size())
+        {
+            words_.resize(index / 64 + 1, 0);
+        }
+        words_[index / 64] |= uint64_t{1} << (index % 64);
+    }
+
+    void Reset(size_t index)
+    {
+        if (index / 64 < words_.size())
+        {
+            words_[index / 64] &= ~(uint64_t{1} << (index % 64));
+        }
+    }
+
+    bool Test(size_t index) const
+    {
+        return index / 64 < words_.size() && (words_[index / 64] >> (index % 64)) & 1u;
+    }
+
+    // Memory used by the bits
+    size_t GetMemoryUsage() const
+    {
+        return words_.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    std::vector<uint64_t> words_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// DocumentFilter - the common predicate for documents: status and range of rating
+// Search server recognizes it and checks documents with per-status bitmaps and the column of ratings
+// instead of calling a predicate function for every document
+
+#include "document.h"
+
+#include <limits>
+#include <optional>
+
+struct DocumentFilter
+{
+    // Documents with any status pass if status is not set
+    std::optional<DocumentStatus> status;
+
+    // Documents with rating in [min_rating, max_rating] pass
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+
+    // Works as an ordinary predicate too
+    bool operator()([[maybe_unused]] int document_id, DocumentStatus document_status, int rating) const
+    {
+        return (!status || *status == document_status) && min_rating <= rating && rating <= max_rating;
+    }
+
+    bool operator==(const DocumentFilter& other) const
+    {
+        return status == other.status && min_rating == other.min_rating && max_rating == other.max_rating;
+    }
+};
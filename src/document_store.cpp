@@ -0,0 +1,119 @@
+#include "document_store.h"
+#include "memory_stats.h"
+
+#include <utility>
+
+// ------------------------------- Constructors ------------------------------- //
+
+DocumentStore::DocumentStore(std::pmr::memory_resource* resource)
+    : numbers_(resource)
+{
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+uint32_t DocumentStore::Add(int document_id, DocumentStatus status, int rating, int word_count, std::string content)
+{
+    const uint32_t number = static_cast<uint32_t>(ids_.size());
+    numbers_.emplace(document_id, number);
+
+    ids_.push_back(document_id);
+    ratings_.push_back(rating);
+    statuses_.push_back(status);
+    word_counts_.push_back(word_count);
+    contents_.push_back(std::move(content));
+
+    status_bitmaps_[static_cast<size_t>(status)].Set(number);
+    return number;
+}
+
+void DocumentStore::Remove(uint32_t number)
+{
+    numbers_.erase(ids_[number]);
+    status_bitmaps_[static_cast<size_t>(statuses_[number])].Reset(number);
+
+    // Free the content, values of other columns are left as they are
+    contents_[number] = std::string();
+}
+
+std::vector<uint32_t> DocumentStore::Compact()
+{
+    std::vector<uint32_t> new_numbers(ids_.size(), NO_DOCUMENT_NUMBER);
+    uint32_t count = 0;
+    for (uint32_t number = 0; number < ids_.size(); ++number)
+    {
+        // An id of a removed document could be added again with another number
+        const auto it = numbers_.find(ids_[number]);
+        if (it == numbers_.end() || it->second != number)
+        {
+            continue;
+        }
+        it->second = count;
+        new_numbers[number] = count;
+        if (count != number)
+        {
+            ids_[count] = ids_[number];
+            ratings_[count] = ratings_[number];
+            statuses_[count] = statuses_[number];
+            word_counts_[count] = word_counts_[number];
+            contents_[count] = std::move(contents_[number]);
+        }
+        ++count;
+    }
+
+    ids_.resize(count);
+    ratings_.resize(count);
+    statuses_.resize(count);
+    word_counts_.resize(count);
+    contents_.resize(count);
+    ids_.shrink_to_fit();
+    ratings_.shrink_to_fit();
+    statuses_.shrink_to_fit();
+    word_counts_.shrink_to_fit();
+    contents_.shrink_to_fit();
+
+    status_bitmaps_ = {};
+    for (uint32_t number = 0; number < count; ++number)
+    {
+        status_bitmaps_[static_cast<size_t>(statuses_[number])].Set(number);
+    }
+    return new_numbers;
+}
+
+bool DocumentStore::Contains(int document_id) const
+{
+    return numbers_.count(document_id) > 0;
+}
+
+uint32_t DocumentStore::GetNumber(int document_id) const
+{
+    return numbers_.at(document_id);
+}
+
+const std::string& DocumentStore::GetContent(uint32_t number) const
+{
+    return contents_[number];
+}
+
+size_t DocumentStore::GetContentMemoryUsage() const
+{
+    size_t bytes = contents_.capacity() * sizeof(std::string);
+    for (const std::string& content : contents_)
+    {
+        bytes += GetStringHeapBytes(content);
+    }
+    return bytes;
+}
+
+size_t DocumentStore::GetMetadataMemoryUsage() const
+{
+    size_t bytes = numbers_.size() * (MAP_NODE_OVERHEAD + sizeof(std::pair<const int, uint32_t>));
+    bytes += ids_.capacity() * sizeof(int) + ratings_.capacity() * sizeof(int) 
+        + statuses_.capacity() * sizeof(DocumentStatus) + word_counts_.capacity() * sizeof(int);
+    for (const DenseBitset& bitmap : status_bitmaps_)
+    {
+        bytes += bitmap.GetMemoryUsage();
+    }
+    return bytes;
+}
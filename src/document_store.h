@@ -0,0 +1,107 @@
+#pragma once
+
+// DocumentStore - metadata of documents stored by columns
+// Every document gets an internal number in the order of adding, columns are dense arrays indexed by it,
+// so the search reads only the columns it needs (status, rating, ...) and never the content
+// Documents of every status are also marked in a per-status bitmap
+
+#include "dense_bitset.h"
+#include "document.h"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Amount of values of DocumentStatus
+const size_t DOCUMENT_STATUS_COUNT = 4;
+
+// New number of a removed document after compaction
+const uint32_t NO_DOCUMENT_NUMBER = UINT32_MAX;
+
+class DocumentStore
+{
+public:
+    // Nodes of the map of ids are allocated from resource
+    explicit DocumentStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Add document and return its internal number
+    uint32_t Add(int document_id, DocumentStatus status, int rating, int word_count, std::string content);
+
+    // Remove document by internal number, the number isn't given to other documents until compaction
+    void Remove(uint32_t number);
+
+    // Give stored documents numbers [0, count of documents) keeping their order, so numbers of removed documents are reclaimed
+    // Return the new number for every old number (NO_DOCUMENT_NUMBER for removed documents)
+    std::vector<uint32_t> Compact();
+
+    // Check if the document with id is stored
+    bool Contains(int document_id) const;
+
+    // Internal number of a stored document
+    // Throws std::out_of_range if there is no such document
+    uint32_t GetNumber(int document_id) const;
+
+    // Content of a stored document
+    const std::string& GetContent(uint32_t number) const;
+
+    // Estimated bytes of contents of documents
+    size_t GetContentMemoryUsage() const;
+
+    // Estimated bytes of other columns, the map of ids and bitmaps of statuses
+    size_t GetMetadataMemoryUsage() const;
+
+    // Amount of given internal numbers, including numbers of removed documents
+    size_t GetNumberCount() const
+    {
+        return ids_.size();
+    }
+
+    // Amount of numbers of removed documents, which are reclaimed by Compact
+    size_t GetRemovedCount() const
+    {
+        return ids_.size() - numbers_.size();
+    }
+
+    int GetId(uint32_t number) const
+    {
+        return ids_[number];
+    }
+
+    int GetRating(uint32_t number) const
+    {
+        return ratings_[number];
+    }
+
+    DocumentStatus GetStatus(uint32_t number) const
+    {
+        return statuses_[number];
+    }
+
+    int GetWordCount(uint32_t number) const
+    {
+        return word_counts_[number];
+    }
+
+    // Bit test in the bitmap of the status
+    bool HasStatus(uint32_t number, DocumentStatus status) const
+    {
+        return status_bitmaps_[static_cast<size_t>(status)].Test(number);
+    }
+
+private:
+    // Id of a document -> internal number
+    std::pmr::map<int, uint32_t> numbers_;
+
+    // Columns, index is an internal number
+    std::vector<int> ids_;
+    std::vector<int> ratings_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<int> word_counts_;
+    std::vector<std::string> contents_;
+
+    // Bitmaps of documents with every status
+    std::array<DenseBitset, DOCUMENT_STATUS_COUNT> status_bitmaps_;
+};
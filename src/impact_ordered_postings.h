@@ -0,0 +1,64 @@
+#pragma once
+
+// ImpactOrderedPostings - secondary layout of a long posting list for early termination of queries
+// Postings are sorted by descending term frequency (impact) and split into tiers: tier k holds postings
+// with term frequency in (max / 2^(k+1), max / 2^k], the last tier holds the rest.
+// A query processes the tiers with the highest impact first and stops when the remaining tiers can't change the top documents
+
+#include "posting_list.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+struct ImpactOrderedPostings
+{
+    static const size_t MAX_TIER_COUNT = 8;
+
+    std::vector<uint32_t> documents;
+    std::vector<double> term_freqs;     // in descending order
+    std::vector<size_t> tier_ends;      // tier k is [tier_ends[k - 1], tier_ends[k])
+
+    size_t size() const
+    {
+        return documents.size();
+    }
+
+    static ImpactOrderedPostings Build(const PostingList& postings)
+    {
+        std::vector<double> term_freqs(postings.size());
+        postings.term_freqs.Decode(0, postings.size(), term_freqs.data());
+        std::vector<size_t> order(postings.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&term_freqs](size_t lhs, size_t rhs)
+            {
+                return term_freqs[lhs] > term_freqs[rhs];
+            });
+
+        ImpactOrderedPostings result;
+        result.documents.reserve(order.size());
+        result.term_freqs.reserve(order.size());
+        for (const size_t i : order)
+        {
+            result.documents.push_back(postings.documents[i]);
+            result.term_freqs.push_back(term_freqs[i]);
+        }
+
+        double bound = result.term_freqs.empty() ? 0.0 : result.term_freqs.front() / 2.0;
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            if (result.term_freqs[i] <= bound && result.tier_ends.size() + 1 < MAX_TIER_COUNT)
+            {
+                result.tier_ends.push_back(i);
+                while (bound > 0.0 && result.term_freqs[i] <= bound)
+                {
+                    bound /= 2.0;
+                }
+            }
+        }
+        result.tier_ends.push_back(result.size());
+        return result;
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+// IndexMemoryResource - pool of memory for nodes of the index (see SearchServerOptions::memory_resource)
+// Nodes of maps and sets of the index have a few fixed sizes, so they are cut from large chunks
+// by size classes instead of calling malloc for every node; freed nodes are reused by the same class.
+// Building and destroying the index then costs a few allocations of chunks, and nodes of a word lie close in memory.
+// Not thread-safe: like the index itself, it must not be changed from several threads at once.
+// The resource must outlive every server using it.
+
+#include <cstddef>
+#include <memory_resource>
+
+class IndexMemoryResource : public std::pmr::unsynchronized_pool_resource
+{
+public:
+    // Nodes of maps are 40-80 bytes; larger blocks (arrays of buckets) go to the upstream resource
+    static const size_t LARGEST_POOL_BLOCK = 256;
+
+    // Chunks grow geometrically up to this amount of blocks
+    static const size_t MAX_BLOCKS_PER_CHUNK = 16384;
+
+    explicit IndexMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : std::pmr::unsynchronized_pool_resource(GetPoolOptions(), upstream)
+    {
+    }
+
+    static std::pmr::pool_options GetPoolOptions()
+    {
+        std::pmr::pool_options options;
+        options.max_blocks_per_chunk = MAX_BLOCKS_PER_CHUNK;
+        options.largest_required_pool_block = LARGEST_POOL_BLOCK;
+        return options;
+    }
+};
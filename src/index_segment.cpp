@@ -0,0 +1,219 @@
+#include "index_segment.h"
+
+#include <tuple>
+
+
+// ------------------------------- MemorySegment ------------------------------- //
+
+void MemorySegment::AddDocument(const SegmentDocument& document, const std::vector<std::pair<std::string_view, double>>& word_freqs)
+{
+    const uint32_t number = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(document);
+    id_to_number_[document.id] = number;
+
+    std::vector<std::string_view>& words = words_of_documents_.emplace_back();
+    words.reserve(word_freqs.size());
+    for (const auto& [word, freq] : word_freqs)
+    {
+        auto postings_it = word_to_postings_.find(word);
+        if (postings_it == word_to_postings_.end())
+        {
+            postings_it = word_to_postings_.emplace(std::string(word), PostingList()).first;
+        }
+        postings_it->second.Append(number, freq);
+        words.push_back(postings_it->first);
+    }
+}
+
+bool MemorySegment::RemoveDocument(int document_id)
+{
+    const auto number_it = id_to_number_.find(document_id);
+    if (number_it == id_to_number_.end())
+    {
+        return false;
+    }
+    const uint32_t number = number_it->second;
+    id_to_number_.erase(number_it);
+
+    for (const std::string_view word : words_of_documents_[number])
+    {
+        const auto postings_it = word_to_postings_.find(word);
+        postings_it->second.Remove(number);
+        if (postings_it->second.empty())
+        {
+            word_to_postings_.erase(postings_it);
+        }
+    }
+    words_of_documents_[number].clear();
+    words_of_documents_[number].shrink_to_fit();
+    return true;
+}
+
+
+// ------------------------------- Constructors ------------------------------- //
+
+std::shared_ptr<IndexSegment> IndexSegment::Seal(const MemorySegment& memory_segment)
+{
+    // Removed documents are dropped, the rest keep their order
+    std::shared_ptr<IndexSegment> segment(new IndexSegment());
+    std::vector<uint32_t> new_numbers(memory_segment.size(), NO_NUMBER);
+    for (uint32_t number = 0; number < memory_segment.size(); ++number)
+    {
+        if (!memory_segment.IsRemoved(number))
+        {
+            new_numbers[number] = static_cast<uint32_t>(segment->size());
+            segment->AppendDocument(memory_segment.GetDocument(number));
+        }
+    }
+
+    // Posting lists of the memory segment contain only documents which are not removed
+    memory_segment.ForEachWord([&segment, &new_numbers](std::string_view word, const PostingList& postings)
+        {
+            for (size_t i = 0; i < postings.size(); ++i)
+            {
+                segment->AppendPosting(new_numbers[postings.documents[i]], postings.term_freqs[i]);
+            }
+            segment->AppendTerm(word);
+        });
+    segment->Finish();
+    return segment;
+}
+
+std::shared_ptr<IndexSegment> IndexSegment::Merge(const std::vector<std::shared_ptr<const IndexSegment>>& segments, std::vector<Source>& sources)
+{
+    // Documents are concatenated in the order of the segments, so postings of a word stay sorted
+    std::shared_ptr<IndexSegment> merged(new IndexSegment());
+    std::vector<std::vector<uint32_t>> new_numbers(segments.size());
+    sources.clear();
+    for (size_t s = 0; s < segments.size(); ++s)
+    {
+        const IndexSegment& segment = *segments[s];
+        new_numbers[s].assign(segment.size(), NO_NUMBER);
+        for (uint32_t number = 0; number < segment.size(); ++number)
+        {
+            if (!segment.IsRemoved(number))
+            {
+                new_numbers[s][number] = static_cast<uint32_t>(merged->size());
+                merged->AppendDocument(segment.GetDocument(number));
+                sources.push_back({s, number});
+            }
+        }
+    }
+
+    // Words of all segments in sorted order, a word of several segments goes in the order of the segments
+    std::vector<std::tuple<std::string_view, size_t, size_t>> terms;
+    for (size_t s = 0; s < segments.size(); ++s)
+    {
+        for (size_t term = 0; term < segments[s]->GetTermCount(); ++term)
+        {
+            terms.emplace_back(segments[s]->GetTerm(term), s, term);
+        }
+    }
+    std::sort(terms.begin(), terms.end());
+
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        const auto& [word, s, term] = terms[i];
+        const IndexSegment& segment = *segments[s];
+        for (uint32_t k = segment.posting_offsets_[term]; k < segment.posting_offsets_[term + 1]; ++k)
+        {
+            const uint32_t number = new_numbers[s][segment.documents_[k]];
+            if (number != NO_NUMBER)
+            {
+                merged->AppendPosting(number, segment.term_freqs_[k]);
+            }
+        }
+        if (i + 1 == terms.size() || std::get<0>(terms[i + 1]) != word)
+        {
+            merged->AppendTerm(word);
+        }
+    }
+    merged->Finish();
+    return merged;
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+bool IndexSegment::RemoveNumber(uint32_t number)
+{
+    const uint64_t bit = uint64_t{1} << (number % 64);
+    if (tombstones_[number / 64].fetch_or(bit, std::memory_order_relaxed) & bit)
+    {
+        return false;
+    }
+    removed_count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t IndexSegment::GetMemoryUsage() const
+{
+    return term_chars_.capacity() * sizeof(char) + term_offsets_.capacity() * sizeof(uint32_t)
+        + posting_offsets_.capacity() * sizeof(uint32_t) + documents_.capacity() * sizeof(uint32_t) + term_freqs_.capacity() * sizeof(double)
+        + ids_.capacity() * sizeof(int) + statuses_.capacity() * sizeof(DocumentStatus) + ratings_.capacity() * sizeof(int)
+        + id_index_.capacity() * sizeof(std::pair<int, uint32_t>) + (size() / 64 + 1) * sizeof(uint64_t);
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+size_t IndexSegment::FindTerm(std::string_view word) const
+{
+    size_t first = 0;
+    size_t last = GetTermCount();
+    while (first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+        if (GetTerm(middle) < word)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return first < GetTermCount() && GetTerm(first) == word ? first : NO_TERM;
+}
+
+uint32_t IndexSegment::FindNumber(int document_id) const
+{
+    const auto it = std::lower_bound(id_index_.begin(), id_index_.end(), std::pair<int, uint32_t>(document_id, 0));
+    return it != id_index_.end() && it->first == document_id ? it->second : NO_NUMBER;
+}
+
+void IndexSegment::AppendDocument(const SegmentDocument& document)
+{
+    id_index_.push_back({document.id, static_cast<uint32_t>(ids_.size())});
+    ids_.push_back(document.id);
+    statuses_.push_back(document.status);
+    ratings_.push_back(document.rating);
+}
+
+void IndexSegment::AppendTerm(std::string_view word)
+{
+    if (documents_.size() == posting_offsets_.back())
+    {
+        return;
+    }
+    term_chars_.insert(term_chars_.end(), word.begin(), word.end());
+    term_offsets_.push_back(static_cast<uint32_t>(term_chars_.size()));
+    posting_offsets_.push_back(static_cast<uint32_t>(documents_.size()));
+}
+
+void IndexSegment::Finish()
+{
+    std::sort(id_index_.begin(), id_index_.end());
+    term_chars_.shrink_to_fit();
+    term_offsets_.shrink_to_fit();
+    posting_offsets_.shrink_to_fit();
+    documents_.shrink_to_fit();
+    term_freqs_.shrink_to_fit();
+
+    const size_t word_count = size() / 64 + 1;
+    tombstones_ = std::make_unique<std::atomic<uint64_t>[]>(word_count);
+    for (size_t i = 0; i < word_count; ++i)
+    {
+        tombstones_[i].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+// Segments of the segmented index (see SegmentedSearchServer)
+// MemorySegment - small mutable segment that absorbs new documents, removing a document takes it out of the posting lists.
+// IndexSegment - immutable segment sealed from the memory segment or merged from other segments.
+// Words are sorted and kept in one buffer of characters, posting lists of all words are laid out one after another,
+// so a segment is a few flat arrays: a word is found by binary search and its postings are read sequentially.
+// Removing a document from an immutable segment only sets its bit in the tombstones, the document is dropped by the next merge.
+// Tombstones are atomic, so a segment can be searched while documents are being removed from it.
+
+#include "document.h"
+#include "posting_list.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Metadata of a document of a segment
+struct SegmentDocument
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    int rating = 0;
+};
+
+class MemorySegment
+{
+public:
+    // Add document with its words and their frequencies
+    void AddDocument(const SegmentDocument& document, const std::vector<std::pair<std::string_view, double>>& word_freqs);
+
+    // Return false if there is no such document in the segment
+    bool RemoveDocument(int document_id);
+
+    bool Contains(int document_id) const
+    {
+        return id_to_number_.count(document_id) > 0;
+    }
+
+    // Internal numbers of the segment, removed documents keep their numbers until the segment is sealed
+    size_t size() const
+    {
+        return documents_.size();
+    }
+
+    // Documents which are not removed
+    size_t GetDocumentCount() const
+    {
+        return id_to_number_.size();
+    }
+
+    const SegmentDocument& GetDocument(uint32_t number) const
+    {
+        return documents_[number];
+    }
+
+    // Id of a removed document can be added again with another number
+    bool IsRemoved(uint32_t number) const
+    {
+        const auto it = id_to_number_.find(documents_[number].id);
+        return it == id_to_number_.end() || it->second != number;
+    }
+
+    // Posting lists contain only documents which are not removed
+    size_t GetDocumentFreq(std::string_view word) const
+    {
+        const auto it = word_to_postings_.find(word);
+        return it == word_to_postings_.end() ? 0 : it->second.size();
+    }
+
+    // Callback(number, term_freq) for every document containing the word
+    template <typename Callback>
+    void ForEachLivePosting(std::string_view word, Callback callback) const
+    {
+        const auto it = word_to_postings_.find(word);
+        if (it == word_to_postings_.end())
+        {
+            return;
+        }
+        const PostingList& postings = it->second;
+        postings.term_freqs.Visit([&postings, &callback](auto read_term_freq)
+            {
+                for (size_t i = 0; i < postings.size(); ++i)
+                {
+                    callback(postings.documents[i], read_term_freq(i));
+                }
+            });
+    }
+
+    // Callback(word, postings) for words in sorted order
+    template <typename Callback>
+    void ForEachWord(Callback callback) const
+    {
+        for (const auto& [word, postings] : word_to_postings_)
+        {
+            callback(std::string_view(word), postings);
+        }
+    }
+
+private:
+    std::map<std::string, PostingList, std::less<>> word_to_postings_;
+    std::vector<SegmentDocument> documents_;
+    std::vector<std::vector<std::string_view>> words_of_documents_;    // keys of word_to_postings_, cleared when a document is removed
+    std::unordered_map<int, uint32_t> id_to_number_;
+};
+
+class IndexSegment
+{
+public:
+    // Document of a merged segment and the place it came from
+    struct Source
+    {
+        size_t segment;
+        uint32_t number;
+    };
+
+    // Segment of the documents of the memory segment which are not removed
+    static std::shared_ptr<IndexSegment> Seal(const MemorySegment& memory_segment);
+
+    // Segment of the documents of segments which are not removed, numbers follow the order of the segments
+    // sources[number] - segment and number of every document of the result
+    static std::shared_ptr<IndexSegment> Merge(const std::vector<std::shared_ptr<const IndexSegment>>& segments, std::vector<Source>& sources);
+
+    // Documents of the segment, removed ones are counted until the segment is merged
+    size_t size() const
+    {
+        return ids_.size();
+    }
+
+    size_t GetRemovedCount() const
+    {
+        return removed_count_.load(std::memory_order_relaxed);
+    }
+
+    // Documents which are not removed
+    size_t GetDocumentCount() const
+    {
+        return size() - GetRemovedCount();
+    }
+
+    SegmentDocument GetDocument(uint32_t number) const
+    {
+        return {ids_[number], statuses_[number], ratings_[number]};
+    }
+
+    bool Contains(int document_id) const
+    {
+        const uint32_t number = FindNumber(document_id);
+        return number != NO_NUMBER && !IsRemoved(number);
+    }
+
+    bool IsRemoved(uint32_t number) const
+    {
+        return (tombstones_[number / 64].load(std::memory_order_relaxed) >> (number % 64)) & 1u;
+    }
+
+    // Set the tombstone of the document, return false if there is no such document or it is already removed
+    bool RemoveDocument(int document_id)
+    {
+        const uint32_t number = FindNumber(document_id);
+        return number != NO_NUMBER && RemoveNumber(number);
+    }
+
+    bool RemoveNumber(uint32_t number);
+
+    // Documents containing the word, removed ones are counted until the segment is merged
+    size_t GetDocumentFreq(std::string_view word) const
+    {
+        const size_t term = FindTerm(word);
+        return term == NO_TERM ? 0 : posting_offsets_[term + 1] - posting_offsets_[term];
+    }
+
+    // Callback(number, term_freq) for every document containing the word which is not removed
+    template <typename Callback>
+    void ForEachLivePosting(std::string_view word, Callback callback) const
+    {
+        const size_t term = FindTerm(word);
+        if (term == NO_TERM)
+        {
+            return;
+        }
+        for (uint32_t i = posting_offsets_[term]; i < posting_offsets_[term + 1]; ++i)
+        {
+            if (!IsRemoved(documents_[i]))
+            {
+                callback(documents_[i], term_freqs_[i]);
+            }
+        }
+    }
+
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr size_t NO_TERM = static_cast<size_t>(-1);
+    static constexpr uint32_t NO_NUMBER = UINT32_MAX;
+
+    IndexSegment() = default;
+
+    std::string_view GetTerm(size_t term) const
+    {
+        return std::string_view(term_chars_.data() + term_offsets_[term], term_offsets_[term + 1] - term_offsets_[term]);
+    }
+
+    size_t GetTermCount() const
+    {
+        return term_offsets_.size() - 1;
+    }
+
+    size_t FindTerm(std::string_view word) const;
+    uint32_t FindNumber(int document_id) const;
+
+    // Building of a segment: documents first, then postings of every word in sorted order followed by the word, then Finish
+    void AppendDocument(const SegmentDocument& document);
+    void AppendPosting(uint32_t number, double term_freq)
+    {
+        documents_.push_back(number);
+        term_freqs_.push_back(term_freq);
+    }
+    // Word of the postings appended after the previous word, a word without postings is skipped
+    void AppendTerm(std::string_view word);
+    void Finish();
+
+    // Words: term k is term_chars_[term_offsets_[k], term_offsets_[k + 1])
+    std::vector<char> term_chars_;
+    std::vector<uint32_t> term_offsets_ = {0};
+
+    // Postings: term k has documents_ and term_freqs_ [posting_offsets_[k], posting_offsets_[k + 1])
+    std::vector<uint32_t> posting_offsets_ = {0};
+    std::vector<uint32_t> documents_;
+    std::vector<double> term_freqs_;
+
+    // Columns of documents by number, numbers sorted by ids
+    std::vector<int> ids_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<int> ratings_;
+    std::vector<std::pair<int, uint32_t>> id_index_;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> tombstones_;
+    std::atomic<size_t> removed_count_ = 0;
+};
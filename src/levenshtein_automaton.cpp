@@ -0,0 +1,56 @@
+#include "levenshtein_automaton.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+LevenshteinAutomaton::LevenshteinAutomaton(std::string_view word, int max_distance)
+    : word_(word)
+{
+    if (max_distance < 0 || max_distance > 2)
+    {
+        throw std::invalid_argument("Error! Edit distance must be from 0 to 2!");
+    }
+    max_distance_ = static_cast<uint8_t>(max_distance);
+}
+
+std::vector<uint8_t> LevenshteinAutomaton::GetStartRow() const
+{
+    std::vector<uint8_t> row(word_.size() + 1);
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        row[i] = static_cast<uint8_t>(std::min<size_t>(i, max_distance_ + 1u));
+    }
+    return row;
+}
+
+uint8_t LevenshteinAutomaton::StepRow(const uint8_t* row, char c, uint8_t* next) const
+{
+    const uint8_t limit = max_distance_ + 1u;
+
+    next[0] = std::min<uint8_t>(row[0] + 1u, limit);
+    uint8_t minimum = next[0];
+    for (size_t i = 1; i <= word_.size(); ++i)
+    {
+        const uint8_t substitution = row[i - 1] + (word_[i - 1] == c ? 0u : 1u);
+        const uint8_t deletion = row[i] + 1u;
+        const uint8_t insertion = next[i - 1] + 1u;
+        next[i] = std::min({substitution, deletion, insertion, limit});
+        minimum = std::min(minimum, next[i]);
+    }
+    return minimum;
+}
+
+bool LevenshteinAutomaton::GetNextPrefix(std::string_view prefix, std::string& next_prefix)
+{
+    next_prefix = std::string(prefix);
+    while (!next_prefix.empty() && static_cast<unsigned char>(next_prefix.back()) == 0xFFu)
+    {
+        next_prefix.pop_back();
+    }
+    if (next_prefix.empty())
+    {
+        return false;
+    }
+    next_prefix.back() = static_cast<char>(static_cast<unsigned char>(next_prefix.back()) + 1u);
+    return true;
+}
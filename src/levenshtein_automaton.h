@@ -0,0 +1,96 @@
+#pragma once
+
+// LevenshteinAutomaton - accepts words within the given edit distance (insertions, deletions, substitutions)
+// from the pattern word. A state is a row of the Levenshtein matrix capped at max_distance + 1,
+// so a state with all values above max_distance can't lead to a match and the whole subtree
+// of the dictionary with this prefix is skipped
+// Distance is counted in bytes, so a multibyte (UTF-8) letter costs more than one edit
+
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class LevenshteinAutomaton
+{
+public:
+    LevenshteinAutomaton(std::string_view word, int max_distance);
+
+    // Walk the dictionary intersecting it with the automaton
+    // States of common prefixes of neighbour words are reused, prefixes that can't match are skipped
+    // Callback(word, distance) is called in lexicographical order and returns false to stop the walk
+    template <typename Callback>
+    void ForEachMatch(const TermDictionary& dictionary, Callback callback) const
+    {
+        // States of prefixes of the previous word are stored one after another:
+        // row k - state after reading k first characters
+        const size_t row_size = word_.size() + 1;
+        std::vector<uint8_t> rows = GetStartRow();
+        std::string_view previous;
+
+        TermDictionary::Cursor cursor(dictionary);
+        while (cursor.IsValid())
+        {
+            const std::string_view word = cursor.GetWord();
+
+            size_t depth = 0;
+            const size_t max_common = std::min({word.size(), previous.size(), rows.size() / row_size - 1});
+            while (depth < max_common && word[depth] == previous[depth])
+            {
+                ++depth;
+            }
+            rows.resize((depth + 1) * row_size);
+
+            bool can_match = true;
+            for (; depth < word.size(); ++depth)
+            {
+                rows.resize(rows.size() + row_size);
+                uint8_t* next = rows.data() + rows.size() - row_size;
+                if (StepRow(next - row_size, word[depth], next) > max_distance_)
+                {
+                    // Even the best continuation is too far
+                    can_match = false;
+                    break;
+                }
+            }
+            previous = word;
+
+            if (!can_match)
+            {
+                // No word with prefix of depth + 1 characters can match
+                std::string next_prefix;
+                if (!GetNextPrefix(word.substr(0, depth + 1), next_prefix))
+                {
+                    return;
+                }
+                cursor.Seek(next_prefix);
+                continue;
+            }
+
+            const uint8_t distance = rows.back();
+            if (distance <= max_distance_ && !callback(word, distance))
+            {
+                return;
+            }
+            cursor.Next();
+        }
+    }
+
+private:
+    // Row of the Levenshtein matrix for the empty read word: distances to every prefix of the pattern
+    std::vector<uint8_t> GetStartRow() const;
+
+    // Calculate the next row after reading character c
+    // Return the minimum of the row
+    uint8_t StepRow(const uint8_t* row, char c, uint8_t* next) const;
+
+    // Smallest string greater than all strings starting with prefix
+    // Return false if there is no such string
+    static bool GetNextPrefix(std::string_view prefix, std::string& next_prefix);
+
+    std::string word_;
+    uint8_t max_distance_;
+};
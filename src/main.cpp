@@ -5,6 +5,7 @@
 #include <execution>
 #include <iostream>
 #include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -53,6 +54,23 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
     return queries;
 }
 
+// Queries of fuzzy words with a typo: sevrer~
+vector<string> GenerateFuzzyQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        string query;
+        const int word_count = uniform_int_distribution(1, max_word_count)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            string word = dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+            word[uniform_int_distribution<int>(0, word.size() - 1)(generator)] = uniform_int_distribution('a', 'z')(generator);
+            query += (query.empty() ? ""s : " "s) + word + "~"s;
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
 template <typename ExecutionPolicy>
 void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
@@ -67,6 +85,20 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 
+vector<string> MakeRequiredQueries(const vector<string>& queries) {
+    vector<string> required_queries;
+    required_queries.reserve(queries.size());
+    for (const string& query : queries) {
+        string required_query;
+        istringstream words(query);
+        for (string word; words >> word;) {
+            required_query += (required_query.empty() ? ""s : " "s) + "+"s + word;
+        }
+        required_queries.push_back(required_query);
+    }
+    return required_queries;
+}
+
 int main() {
     mt19937 generator;
 
@@ -82,4 +114,11 @@ int main() {
 
     TEST(seq);
     TEST(par);
+
+    const auto fuzzy_queries = GenerateFuzzyQueries(generator, dictionary, 100, 3);
+    Test("fuzzy"s, search_server, fuzzy_queries, execution::seq);
+
+    const auto short_queries = GenerateQueries(generator, dictionary, 100, 3);
+    Test("or"s, search_server, short_queries, execution::seq);
+    Test("and"s, search_server, MakeRequiredQueries(short_queries), execution::seq);
 }
\ No newline at end of file
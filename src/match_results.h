@@ -0,0 +1,38 @@
+#pragma once
+
+// MatchResults - words of a query found in a batch of documents (see SearchServer::MatchDocuments)
+// Words of all documents are stored in one buffer, so a batch doesn't allocate a vector per document
+// Words are views into the dictionary of the server, they are valid while the server exists
+
+#include "document.h"
+#include "paginator.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+struct MatchResults
+{
+    using WordIterator = std::vector<std::string_view>::const_iterator;
+
+    // Documents in the order of the request
+    std::vector<int> document_ids;
+    std::vector<DocumentStatus> statuses;
+
+    // Matched words of all documents in ascending order within a document
+    std::vector<std::string_view> words;
+
+    // Words of the i-th document end at word_ends[i] and start at the end of the previous document
+    std::vector<size_t> word_ends;
+
+    size_t size() const
+    {
+        return document_ids.size();
+    }
+
+    IteratorRange<WordIterator> GetWords(size_t index) const
+    {
+        const size_t first = index == 0 ? 0 : word_ends[index - 1];
+        return IteratorRange<WordIterator>(words.begin() + first, words.begin() + word_ends[index]);
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// MemoryStats - estimated memory of the structures of the search server (see SearchServer::GetMemoryStats)
+// Containers are estimated by their capacity and the node layout of libstdc++, overhead of the allocator isn't counted
+
+#include <cstddef>
+#include <string>
+
+// Approximate size of a node of std::map and std::set (color, parent, left, right)
+const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+// Heap memory of a string, short strings are stored inside the object
+inline size_t GetStringHeapBytes(const std::string& str)
+{
+    return str.capacity() > 15 ? str.capacity() + 1 : 0;
+}
+
+struct MemoryStats
+{
+    size_t dictionary = 0;          // strings of words, their ids and sorted order, stop-words
+    size_t postings = 0;            // posting lists and their impact-ordered layouts
+    size_t forward_index = 0;       // words of every document (see SearchServerOptions::forward_index)
+    size_t content = 0;             // texts of documents
+    size_t metadata = 0;            // columns of the document store, bitmaps of statuses, ids of documents
+    size_t positional_index = 0;    // positions of words for phrase queries
+
+    size_t GetTotal() const
+    {
+        return dictionary + postings + forward_index + content + metadata + positional_index;
+    }
+};
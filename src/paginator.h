@@ -4,6 +4,7 @@
 
 
 #include <iostream>
+#include <iterator>
 #include <vector>
 #include <deque>
 #include <numeric>
@@ -89,5 +90,5 @@ std::ostream& operator<<(std::ostream& out, const IteratorRange<Iterator>& range
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) 
 {
-    return Paginator(begin(c), end(c), page_size);
+    return Paginator(std::begin(c), std::end(c), page_size);
 }
@@ -0,0 +1,251 @@
+#include "positional_index.h"
+#include "memory_stats.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+
+// ------------------------------- Constructors ------------------------------- //
+
+PositionalIndex::PositionalIndex(std::pmr::memory_resource* resource)
+    : word_to_document_positions_(resource)
+{
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+void PositionalIndex::AddDocument(uint32_t document, const std::vector<std::pair<std::string_view, uint32_t>>& word_positions)
+{
+    // Group positions by words
+    std::map<std::string_view, std::vector<uint32_t>> positions_by_word;
+    for (const auto& [word, position] : word_positions)
+    {
+        positions_by_word[word].push_back(position);
+    }
+
+    for (const auto& [word, positions] : positions_by_word)
+    {
+        EncodePositions(positions, word_to_document_positions_[word][document]);
+    }
+}
+
+void PositionalIndex::RemoveDocument(uint32_t document, const std::vector<std::string_view>& words)
+{
+    for (const std::string_view word : words)
+    {
+        const auto it = word_to_document_positions_.find(word);
+        if (it == word_to_document_positions_.end())
+        {
+            continue;
+        }
+        it->second.erase(document);
+        if (it->second.empty())
+        {
+            word_to_document_positions_.erase(it);
+        }
+    }
+}
+
+void PositionalIndex::RemoveDocuments(std::string_view word, const std::vector<uint32_t>& documents)
+{
+    const auto it = word_to_document_positions_.find(word);
+    if (it == word_to_document_positions_.end())
+    {
+        return;
+    }
+    for (const uint32_t document : documents)
+    {
+        it->second.erase(document);
+    }
+    if (it->second.empty())
+    {
+        word_to_document_positions_.erase(it);
+    }
+}
+
+void PositionalIndex::Renumber(const std::vector<uint32_t>& new_numbers)
+{
+    for (auto& [word, document_positions] : word_to_document_positions_)
+    {
+        // New numbers keep the order, so every document is appended to the end of the new map
+        std::pmr::map<uint32_t, EncodedPositions> renumbered(document_positions.get_allocator());
+        for (auto& [document, positions] : document_positions)
+        {
+            renumbered.emplace_hint(renumbered.end(), new_numbers[document], std::move(positions));
+        }
+        document_positions = std::move(renumbered);
+    }
+}
+
+std::vector<uint32_t> PositionalIndex::FindPhraseDocuments(const std::vector<PhraseWord>& phrase) const
+{
+    std::vector<uint32_t> result;
+    if (phrase.empty())
+    {
+        return result;
+    }
+
+    // Posting lists of the phrase words
+    std::vector<const std::pmr::map<uint32_t, EncodedPositions>*> postings;
+    for (const auto& phrase_word : phrase)
+    {
+        const auto it = word_to_document_positions_.find(phrase_word.word);
+        if (it == word_to_document_positions_.end())
+        {
+            return result;
+        }
+        postings.push_back(&it->second);
+    }
+
+    // Start from the rarest word: only its documents can contain the phrase
+    std::vector<size_t> order(phrase.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+        [&postings](size_t lhs, size_t rhs)
+        {
+            return postings[lhs]->size() < postings[rhs]->size();
+        });
+
+    std::vector<PhraseWord> ordered_phrase;
+    for (const size_t index : order)
+    {
+        ordered_phrase.push_back(phrase[index]);
+    }
+
+    std::vector<const EncodedPositions*> positions(phrase.size());
+    MatchBuffers buffers;
+    for (const auto& [document, rarest_positions] : *postings[order[0]])
+    {
+        positions[0] = &rarest_positions;
+
+        // Intersect with the other words in order of their rarity
+        bool has_all_words = true;
+        for (size_t i = 1; i < order.size() && has_all_words; ++i)
+        {
+            const auto& posting = *postings[order[i]];
+            const auto it = posting.find(document);
+            has_all_words = it != posting.end();
+            if (has_all_words)
+            {
+                positions[i] = &it->second;
+            }
+        }
+
+        if (has_all_words && MatchPositions(positions, ordered_phrase, buffers))
+        {
+            result.push_back(document);
+        }
+    }
+    return result;
+}
+
+bool PositionalIndex::ContainsPhrase(uint32_t document, const std::vector<PhraseWord>& phrase) const
+{
+    if (phrase.empty())
+    {
+        return false;
+    }
+
+    std::vector<const EncodedPositions*> positions;
+    for (const auto& phrase_word : phrase)
+    {
+        const auto word_it = word_to_document_positions_.find(phrase_word.word);
+        if (word_it == word_to_document_positions_.end())
+        {
+            return false;
+        }
+        const auto document_it = word_it->second.find(document);
+        if (document_it == word_it->second.end())
+        {
+            return false;
+        }
+        positions.push_back(&document_it->second);
+    }
+    MatchBuffers buffers;
+    return MatchPositions(positions, phrase, buffers);
+}
+
+PositionalIndex::MemoryUsage PositionalIndex::GetMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (const auto& [word, documents] : word_to_document_positions_)
+    {
+        usage.total_bytes += MAP_NODE_OVERHEAD + sizeof(word) + sizeof(documents);
+        for (const auto& [document, encoded] : documents)
+        {
+            usage.encoded_bytes += encoded.size();
+            usage.total_bytes += MAP_NODE_OVERHEAD + sizeof(document) + sizeof(encoded) + encoded.capacity();
+            // Every byte without the continuation bit ends a position
+            usage.position_count += std::count_if(encoded.begin(), encoded.end(),
+                [](uint8_t byte)
+                {
+                    return (byte & 0x80u) == 0;
+                });
+        }
+    }
+    return usage;
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+void PositionalIndex::EncodePositions(const std::vector<uint32_t>& positions, EncodedPositions& encoded)
+{
+    encoded.clear();
+    uint32_t previous = 0;
+    for (const uint32_t position : positions)
+    {
+        // Store the difference with the previous position by 7 bits in a byte
+        uint32_t delta = position - previous;
+        previous = position;
+        while (delta >= 0x80u)
+        {
+            encoded.push_back(static_cast<uint8_t>(delta | 0x80u));
+            delta >>= 7;
+        }
+        encoded.push_back(static_cast<uint8_t>(delta));
+    }
+    encoded.shrink_to_fit();
+}
+
+void PositionalIndex::DecodePhraseStarts(const EncodedPositions& encoded, uint32_t offset, std::vector<uint32_t>& starts)
+{
+    starts.clear();
+    uint32_t previous = 0;
+    uint32_t delta = 0;
+    int shift = 0;
+    for (const uint8_t byte : encoded)
+    {
+        delta |= static_cast<uint32_t>(byte & 0x7Fu) << shift;
+        if (byte & 0x80u)
+        {
+            shift += 7;
+            continue;
+        }
+        previous += delta;
+        if (previous >= offset)
+        {
+            starts.push_back(previous - offset);
+        }
+        delta = 0;
+        shift = 0;
+    }
+}
+
+bool PositionalIndex::MatchPositions(const std::vector<const EncodedPositions*>& positions, const std::vector<PhraseWord>& phrase,
+    MatchBuffers& buffers)
+{
+    // Normalized positions of a word - possible positions of the beginning of the phrase
+    DecodePhraseStarts(*positions[0], phrase[0].offset, buffers.starts);
+    for (size_t i = 1; i < phrase.size() && !buffers.starts.empty(); ++i)
+    {
+        DecodePhraseStarts(*positions[i], phrase[i].offset, buffers.word_starts);
+        buffers.common_starts.clear();
+        std::set_intersection(buffers.starts.begin(), buffers.starts.end(), buffers.word_starts.begin(), buffers.word_starts.end(),
+            std::back_inserter(buffers.common_starts));
+        buffers.starts.swap(buffers.common_starts);
+    }
+    return !buffers.starts.empty();
+}
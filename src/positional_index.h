@@ -0,0 +1,83 @@
+#pragma once
+
+// PositionalIndex - stores positions of every word in every document
+// Positions of a word in a document are kept sorted and delta-encoded (varint),
+// so most of the positions take 1 byte
+// Used for exact phrase search: "high availability"
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// Word of a phrase with its offset from the beginning of the phrase
+struct PhraseWord
+{
+    std::string_view word;
+    uint32_t offset;
+};
+
+class PositionalIndex
+{
+public:
+    // Information about memory used by the index
+    struct MemoryUsage
+    {
+        size_t position_count = 0;     // amount of stored positions
+        size_t encoded_bytes = 0;      // bytes of delta-encoded position lists
+        size_t total_bytes = 0;        // estimated bytes including containers overhead
+    };
+
+    // Nodes of the maps are allocated from resource
+    explicit PositionalIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Save positions of words of the document
+    // Params - internal number of the document, its words with their positions (sorted by position)
+    // Words must stay valid until the document is removed
+    void AddDocument(uint32_t document, const std::vector<std::pair<std::string_view, uint32_t>>& word_positions);
+
+    // Remove all positions of the document
+    // Params - internal number of the document, its unique words
+    void RemoveDocument(uint32_t document, const std::vector<std::string_view>& words);
+
+    // Remove positions of the word in the documents
+    // Params - the word, internal numbers of documents containing it
+    void RemoveDocuments(std::string_view word, const std::vector<uint32_t>& documents);
+
+    // Replace internal numbers of documents by new_numbers[number], which keep the order (see DocumentStore::Compact)
+    void Renumber(const std::vector<uint32_t>& new_numbers);
+
+    // Find all documents containing the phrase
+    // Return sorted internal numbers of documents
+    std::vector<uint32_t> FindPhraseDocuments(const std::vector<PhraseWord>& phrase) const;
+
+    // Check if the document contains the phrase
+    bool ContainsPhrase(uint32_t document, const std::vector<PhraseWord>& phrase) const;
+
+    MemoryUsage GetMemoryUsage() const;
+
+private:
+    using EncodedPositions = std::vector<uint8_t>;
+
+    // Buffers of MatchPositions, reused for every candidate document of a phrase
+    struct MatchBuffers
+    {
+        std::vector<uint32_t> starts;
+        std::vector<uint32_t> word_starts;
+        std::vector<uint32_t> common_starts;
+    };
+
+    static void EncodePositions(const std::vector<uint32_t>& positions, EncodedPositions& encoded);
+
+    // Write positions which are at least offset, minus offset, to starts
+    static void DecodePhraseStarts(const EncodedPositions& encoded, uint32_t offset, std::vector<uint32_t>& starts);
+
+    // Check positions of already found posting lists (ordered by rarity of the words)
+    static bool MatchPositions(const std::vector<const EncodedPositions*>& positions, const std::vector<PhraseWord>& phrase,
+        MatchBuffers& buffers);
+
+    // Key - word (owned by the term dictionary of the server), value - map of internal number of a document 
+    // and encoded positions of the word in the document
+    std::pmr::map<std::string_view, std::pmr::map<uint32_t, EncodedPositions>> word_to_document_positions_;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+// Intersection of sorted lists of internal numbers of documents
+// Lists of similar sizes are merged by blocks of 4 numbers (SSE2 when it is available),
+// a short list is intersected with a long one by galloping (exponential) search
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Longer list is galloped if it is this times longer than the shorter one
+const size_t GALLOPING_SIZE_RATIO = 32;
+
+// Index of the first value not less than target, starting from index low
+// Exponential search from low, then a binary search inside the found range
+inline size_t GallopTo(const std::vector<uint32_t>& values, size_t low, uint32_t target)
+{
+    size_t step = 1;
+    while (low + step < values.size() && values[low + step] < target)
+    {
+        step *= 2;
+    }
+    const auto first = values.begin() + std::min(low + step / 2, values.size());
+    const auto last = values.begin() + std::min(low + step + 1, values.size());
+    return std::lower_bound(first, last, target) - values.begin();
+}
+
+// Call callback(lhs_index, rhs_index) for every common value in ascending order
+// Every value of the shorter list is galloped for in the longer one
+template <typename Callback>
+void ForEachCommon(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs, Callback callback)
+{
+    const bool is_lhs_small = lhs.size() <= rhs.size();
+    const auto& small = is_lhs_small ? lhs : rhs;
+    const auto& big = is_lhs_small ? rhs : lhs;
+
+    size_t low = 0;
+    for (size_t i = 0; i < small.size(); ++i)
+    {
+        low = GallopTo(big, low, small[i]);
+        if (low == big.size())
+        {
+            return;
+        }
+        if (big[low] == small[i])
+        {
+            is_lhs_small ? callback(i, low) : callback(low, i);
+        }
+    }
+}
+
+inline std::vector<uint32_t> GallopingIntersect(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs)
+{
+    std::vector<uint32_t> result;
+    ForEachCommon(lhs, rhs,
+        [&lhs, &result](size_t lhs_index, [[maybe_unused]] size_t rhs_index)
+        {
+            result.push_back(lhs[lhs_index]);
+        });
+    return result;
+}
+
+// Merge of lists of similar sizes
+// With SSE2 every block of 4 numbers of one list is compared with all rotations of a block of the other list
+inline std::vector<uint32_t> BlockIntersect(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs)
+{
+    std::vector<uint32_t> result;
+    size_t i = 0, j = 0;
+
+#ifdef __SSE2__
+    while (i + 4 <= lhs.size() && j + 4 <= rhs.size())
+    {
+        const __m128i lhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i));
+        const __m128i rhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + j));
+        const __m128i equal = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi32(lhs_block, rhs_block),
+                _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(
+                _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(1, 0, 3, 2))),
+                _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(2, 1, 0, 3)))));
+
+        // Bit k is set if lhs[i + k] is in the block of rhs
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        for (int k = 0; k < 4; ++k)
+        {
+            if ((mask >> k) & 1)
+            {
+                result.push_back(lhs[i + k]);
+            }
+        }
+
+        // The block with the smaller last number can't have more common numbers
+        const uint32_t lhs_last = lhs[i + 3];
+        const uint32_t rhs_last = rhs[j + 3];
+        if (lhs_last <= rhs_last)
+        {
+            i += 4;
+        }
+        if (rhs_last <= lhs_last)
+        {
+            j += 4;
+        }
+    }
+#endif
+
+    while (i < lhs.size() && j < rhs.size())
+    {
+        if (lhs[i] < rhs[j])
+        {
+            ++i;
+        }
+        else if (rhs[j] < lhs[i])
+        {
+            ++j;
+        }
+        else
+        {
+            result.push_back(lhs[i]);
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+// Intersection choosing the algorithm by sizes of the lists
+inline std::vector<uint32_t> IntersectPostings(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs)
+{
+    const size_t small = std::min(lhs.size(), rhs.size());
+    const size_t big = std::max(lhs.size(), rhs.size());
+    return small * GALLOPING_SIZE_RATIO < big ? GallopingIntersect(lhs, rhs) : BlockIntersect(lhs, rhs);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// PostingList - documents containing a word and term frequencies of the word in them
+// Documents are internal numbers sorted in ascending order. Numbers are given to documents
+// in the order of adding, so a new document is appended to the end of the lists
+
+#include "term_freq_column.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct PostingList
+{
+    std::vector<uint32_t> documents;
+    TermFreqColumn term_freqs;
+
+    size_t size() const
+    {
+        return documents.size();
+    }
+
+    bool empty() const
+    {
+        return documents.empty();
+    }
+
+    // Add document with number greater than all numbers in the list
+    void Append(uint32_t document, double term_freq)
+    {
+        documents.push_back(document);
+        term_freqs.push_back(term_freq);
+    }
+
+    bool Contains(uint32_t document) const
+    {
+        return std::binary_search(documents.begin(), documents.end(), document);
+    }
+
+    // Replace numbers of documents by new_numbers[number], which keep the order (see DocumentStore::Compact)
+    void Renumber(const std::vector<uint32_t>& new_numbers)
+    {
+        for (uint32_t& document : documents)
+        {
+            document = new_numbers[document];
+        }
+    }
+
+    // Remove all documents for which is_removed(document) is true in one linear pass
+    // Return amount of the removed documents
+    template <typename Predicate>
+    size_t RemoveIf(Predicate is_removed)
+    {
+        term_freqs.RemoveIf([this, &is_removed](size_t index)
+            {
+                return is_removed(documents[index]);
+            });
+        const size_t old_size = documents.size();
+        documents.erase(std::remove_if(documents.begin(), documents.end(), is_removed), documents.end());
+        return old_size - documents.size();
+    }
+
+    void Remove(uint32_t document)
+    {
+        const auto it = std::lower_bound(documents.begin(), documents.end(), document);
+        if (it != documents.end() && *it == document)
+        {
+            term_freqs.erase(it - documents.begin());
+            documents.erase(it);
+        }
+    }
+};
@@ -1,6 +1,4 @@
 #include "process_queries.h"
-#include <algorithm>
-#include <execution>
 
 // Finding result of queries. For every query in queries result is a vector of documents
 // Params: SearchServer, vector<string> queries
@@ -9,15 +7,8 @@ std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries)
 {
-    std::vector<std::vector<Document>> res(queries.size());
-    std::transform(
-        std::execution::par,
-        queries.begin(), queries.end(),
-        res.begin(),
-        [&search_server](const std::string& str){
-            return search_server.FindTopDocuments(str);
-        });
-    return res;
+    // Queries are tasks of the thread pool of the server, heavy ones are split by ranges of documents
+    return search_server.FindTopDocumentsBatch(queries);
 }
 
 // Finding result of queries documents as a "row"
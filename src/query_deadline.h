@@ -0,0 +1,101 @@
+#pragma once
+
+// Cooperative stopping of queries (see SearchServer::FindTopDocumentsAsync)
+// Scoring checks QueryDeadline between blocks of postings and stops when the deadline passed or the query was cancelled,
+// documents scored so far are returned as a truncated result
+
+#include "document.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Cancels the queries it was passed to. Copies share the state, so the caller keeps a copy to cancel
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : is_cancelled_(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    void Cancel()
+    {
+        is_cancelled_->store(true, std::memory_order_relaxed);
+    }
+
+    bool IsCancelled() const
+    {
+        return is_cancelled_->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> is_cancelled_;
+};
+
+// Top documents of a query which may be stopped before scanning all postings
+struct TopDocumentsResult
+{
+    std::vector<Document> documents;
+    bool truncated = false;     // the best documents of the postings scanned before the stop
+};
+
+class QueryDeadline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Postings scanned between checks of the deadline (a check reads the clock)
+    static const size_t CHECK_INTERVAL = 4096;
+
+    // Deadline which never expires
+    QueryDeadline() = default;
+
+    QueryDeadline(Clock::time_point time, std::optional<CancellationToken> token = std::nullopt)
+        : time_(time), token_(std::move(token))
+    {
+    }
+
+    QueryDeadline(const QueryDeadline&) = delete;
+    QueryDeadline& operator=(const QueryDeadline&) = delete;
+
+    // Check if the query must stop. Once expired, the deadline stays expired
+    // Called only before some remaining work, so an expired deadline means the result is truncated
+    bool IsExpired() const
+    {
+        if (is_expired_.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+        if (token_ && token_->IsCancelled())
+        {
+            is_cancelled_.store(true, std::memory_order_relaxed);
+            is_expired_.store(true, std::memory_order_relaxed);
+        }
+        else if (time_ && Clock::now() >= *time_)
+        {
+            is_expired_.store(true, std::memory_order_relaxed);
+        }
+        return is_expired_.load(std::memory_order_relaxed);
+    }
+
+    // Some check found the deadline expired
+    bool WasExpired() const
+    {
+        return is_expired_.load(std::memory_order_relaxed);
+    }
+
+    // The deadline expired because the query was cancelled
+    bool WasCancelled() const
+    {
+        return is_cancelled_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::optional<Clock::time_point> time_;
+    std::optional<CancellationToken> token_;
+    mutable std::atomic<bool> is_expired_{false};
+    mutable std::atomic<bool> is_cancelled_{false};
+};
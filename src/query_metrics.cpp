@@ -0,0 +1,182 @@
+#include "query_metrics.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Boundaries of histograms in Prometheus export, nanoseconds
+    const std::array<uint64_t, 22> PROMETHEUS_BOUNDARIES = {
+        1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+        1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000, 100'000'000, 250'000'000, 500'000'000,
+        1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000
+    };
+
+    // Index of the highest set bit
+    size_t GetExponent(uint64_t value)
+    {
+        return 63 - __builtin_clzll(value);
+    }
+}
+
+std::string_view GetStageName(QueryStage stage)
+{
+    switch (stage)
+    {
+    case QueryStage::PARSE:
+        return "parse";
+    case QueryStage::SCAN:
+        return "scan";
+    case QueryStage::MINUS_FILTER:
+        return "minus_filter";
+    case QueryStage::SORT:
+        return "sort";
+    case QueryStage::BUILD_RESULT:
+        return "build_result";
+    }
+    return "unknown";
+}
+
+
+// ------------------------------- HistogramSnapshot ------------------------------- //
+
+uint64_t HistogramSnapshot::GetQuantile(double quantile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const uint64_t rank = std::min(static_cast<uint64_t>(quantile * count), count - 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen > rank)
+        {
+            return LatencyHistogram::GetBucketUpperBound(i);
+        }
+    }
+    return LatencyHistogram::GetBucketUpperBound(counts.size() - 1);
+}
+
+uint64_t HistogramSnapshot::CountNotGreater(uint64_t value) const
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < counts.size() && LatencyHistogram::GetBucketUpperBound(i) <= value + 1; ++i)
+    {
+        result += counts[i];
+    }
+    return result;
+}
+
+
+// ------------------------------- LatencyHistogram ------------------------------- //
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    counts_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::GetSnapshot() const
+{
+    HistogramSnapshot snapshot;
+    snapshot.counts.reserve(BUCKET_COUNT);
+    // The total is the sum of the buckets, so it always equals the +Inf bucket of Prometheus
+    for (const auto& count : counts_)
+    {
+        snapshot.counts.push_back(count.load(std::memory_order_relaxed));
+        snapshot.count += snapshot.counts.back();
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+    if (value < LINEAR_LIMIT)
+    {
+        return value;
+    }
+    const size_t exponent = GetExponent(value);
+    if (exponent >= MAX_EXPONENT)
+    {
+        return BUCKET_COUNT - 1;
+    }
+    const size_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & ((size_t{1} << SUB_BUCKET_BITS) - 1);
+    return LINEAR_LIMIT + (exponent - 4) * (size_t{1} << SUB_BUCKET_BITS) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(size_t index)
+{
+    if (index < LINEAR_LIMIT)
+    {
+        return index;
+    }
+    const size_t exponent = (index - LINEAR_LIMIT) / (size_t{1} << SUB_BUCKET_BITS) + 4;
+    const uint64_t sub_bucket = (index - LINEAR_LIMIT) % (size_t{1} << SUB_BUCKET_BITS);
+    return ((uint64_t{1} << SUB_BUCKET_BITS) + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t index)
+{
+    if (index < LINEAR_LIMIT)
+    {
+        return index + 1;
+    }
+    const size_t exponent = (index - LINEAR_LIMIT) / (size_t{1} << SUB_BUCKET_BITS) + 4;
+    return GetBucketLowerBound(index) + (uint64_t{1} << (exponent - SUB_BUCKET_BITS));
+}
+
+
+// ------------------------------- QueryMetrics ------------------------------- //
+
+QueryMetricsSnapshot QueryMetrics::GetSnapshot() const
+{
+    QueryMetricsSnapshot snapshot;
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i)
+    {
+        snapshot.stage_durations[i] = stage_durations_[i].GetSnapshot();
+    }
+    snapshot.queries = queries_.load(std::memory_order_relaxed);
+    snapshot.postings_scanned = postings_scanned_.load(std::memory_order_relaxed);
+    snapshot.candidates = candidates_.load(std::memory_order_relaxed);
+    snapshot.page_cache_hits = page_cache_hits_.load(std::memory_order_relaxed);
+    snapshot.page_cache_misses = page_cache_misses_.load(std::memory_order_relaxed);
+    snapshot.cancelled_queries = cancelled_queries_.load(std::memory_order_relaxed);
+    snapshot.deadline_exceeded_queries = deadline_exceeded_queries_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void WritePrometheusMetrics(std::ostream& out, const QueryMetricsSnapshot& snapshot)
+{
+    out << "# HELP search_server_stage_duration_seconds Duration of stages of FindTopDocuments\n";
+    out << "# TYPE search_server_stage_duration_seconds histogram\n";
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i)
+    {
+        const std::string_view stage = GetStageName(static_cast<QueryStage>(i));
+        const HistogramSnapshot& histogram = snapshot.stage_durations[i];
+        for (const uint64_t boundary : PROMETHEUS_BOUNDARIES)
+        {
+            out << "search_server_stage_duration_seconds_bucket{stage=\"" << stage << "\",le=\"" << boundary / 1e9 << "\"} "
+                << histogram.CountNotGreater(boundary) << '\n';
+        }
+        out << "search_server_stage_duration_seconds_bucket{stage=\"" << stage << "\",le=\"+Inf\"} " << histogram.count << '\n';
+        out << "search_server_stage_duration_seconds_sum{stage=\"" << stage << "\"} " << histogram.sum / 1e9 << '\n';
+        out << "search_server_stage_duration_seconds_count{stage=\"" << stage << "\"} " << histogram.count << '\n';
+    }
+
+    const auto write_counter = [&out](std::string_view name, std::string_view help, uint64_t value)
+    {
+        out << "# HELP " << name << ' ' << help << '\n';
+        out << "# TYPE " << name << " counter\n";
+        out << name << ' ' << value << '\n';
+    };
+    write_counter("search_server_queries_total", "Queries of FindTopDocuments", snapshot.queries);
+    write_counter("search_server_postings_scanned_total", "Entries of posting lists visited by queries", snapshot.postings_scanned);
+    write_counter("search_server_candidates_total", "Documents scored by queries", snapshot.candidates);
+    write_counter("search_server_page_cache_hits_total", "Pages served from the cached results", snapshot.page_cache_hits);
+    write_counter("search_server_page_cache_misses_total", "Pages that required a search", snapshot.page_cache_misses);
+    write_counter("search_server_queries_cancelled_total", "Asynchronous queries stopped by cancellation", snapshot.cancelled_queries);
+    write_counter("search_server_queries_deadline_exceeded_total", "Asynchronous queries stopped by the deadline",
+        snapshot.deadline_exceeded_queries);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+// QueryMetrics - statistics of stages of the search for monitoring
+// Durations of stages are recorded with nanosecond resolution into lock-free log-linear (HDR-like) histograms:
+// every power of two is split into 8 sub-buckets, so a value is known with precision of 12.5%
+// Collection is switched on by SearchServerOptions::collect_query_metrics, a switched off StageTimer doesn't read the clock
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stages of FindTopDocuments
+enum class QueryStage
+{
+    PARSE,          // parsing of the query, expansion of prefixes and fuzzy words
+    SCAN,           // scan of posting lists and calculation of relevance
+    MINUS_FILTER,   // collecting documents with minus-words, phrases and required words
+    SORT,           // selection of the top documents
+    BUILD_RESULT,   // building documents of the result from accumulated relevance
+};
+
+const size_t QUERY_STAGE_COUNT = 5;
+
+// Name of the stage for reports
+std::string_view GetStageName(QueryStage stage);
+
+// Copy of a histogram at some moment
+struct HistogramSnapshot
+{
+    // Counts of values in buckets (see LatencyHistogram)
+    std::vector<uint64_t> counts;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    // Upper bound of the bucket containing the quantile (0.5 - median, 0.99 - 99th percentile)
+    uint64_t GetQuantile(double quantile) const;
+
+    // Amount of values not greater than value (values of the bucket containing value are counted if the bucket ends at value)
+    uint64_t CountNotGreater(uint64_t value) const;
+};
+
+class LatencyHistogram
+{
+public:
+    // Values under LINEAR_LIMIT have own buckets, greater values are split by powers of two
+    static const uint64_t LINEAR_LIMIT = 16;
+    static const size_t SUB_BUCKET_BITS = 3;
+    static const size_t MAX_EXPONENT = 48;
+    static const size_t BUCKET_COUNT = LINEAR_LIMIT + (MAX_EXPONENT - 4) * (size_t{1} << SUB_BUCKET_BITS);
+
+    void Record(uint64_t value);
+
+    HistogramSnapshot GetSnapshot() const;
+
+    static size_t GetBucketIndex(uint64_t value);
+
+    // Bucket contains values [lower bound, upper bound)
+    static uint64_t GetBucketLowerBound(size_t index);
+    static uint64_t GetBucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts_{};
+    std::atomic<uint64_t> sum_{0};
+};
+
+// Copy of all metrics at some moment
+struct QueryMetricsSnapshot
+{
+    std::array<HistogramSnapshot, QUERY_STAGE_COUNT> stage_durations;     // nanoseconds
+    uint64_t queries = 0;
+    uint64_t postings_scanned = 0;
+    uint64_t candidates = 0;
+    uint64_t page_cache_hits = 0;
+    uint64_t page_cache_misses = 0;
+    uint64_t cancelled_queries = 0;
+    uint64_t deadline_exceeded_queries = 0;
+};
+
+class QueryMetrics
+{
+public:
+    void RecordStage(QueryStage stage, std::chrono::nanoseconds duration)
+    {
+        stage_durations_[static_cast<size_t>(stage)].Record(duration.count());
+    }
+
+    void AddQuery()
+    {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void AddPostingsScanned(uint64_t count)
+    {
+        postings_scanned_.fetch_add(count, std::memory_order_relaxed);
+    }
+    void AddCandidates(uint64_t count)
+    {
+        candidates_.fetch_add(count, std::memory_order_relaxed);
+    }
+    void AddPageCacheHit(bool is_hit)
+    {
+        (is_hit ? page_cache_hits_ : page_cache_misses_).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Query stopped before scanning all postings: by cancellation or by the deadline
+    void AddTruncatedQuery(bool is_cancelled)
+    {
+        (is_cancelled ? cancelled_queries_ : deadline_exceeded_queries_).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    QueryMetricsSnapshot GetSnapshot() const;
+
+private:
+    std::array<LatencyHistogram, QUERY_STAGE_COUNT> stage_durations_;
+    std::atomic<uint64_t> queries_{0};
+    std::atomic<uint64_t> postings_scanned_{0};
+    std::atomic<uint64_t> candidates_{0};
+    std::atomic<uint64_t> page_cache_hits_{0};
+    std::atomic<uint64_t> page_cache_misses_{0};
+    std::atomic<uint64_t> cancelled_queries_{0};
+    std::atomic<uint64_t> deadline_exceeded_queries_{0};
+};
+
+// Write metrics in the text format of Prometheus
+// Histograms are exported with fixed boundaries from 1 microsecond to 10 seconds
+void WritePrometheusMetrics(std::ostream& out, const QueryMetricsSnapshot& snapshot);
+
+// Measure duration of a scope and record it as a stage
+// Does nothing if metrics is nullptr (collection is switched off)
+class StageTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StageTimer(QueryMetrics* metrics, QueryStage stage)
+        : metrics_(metrics), stage_(stage)
+    {
+        if (metrics_)
+        {
+            start_ = Clock::now();
+        }
+    }
+
+    ~StageTimer()
+    {
+        if (metrics_)
+        {
+            metrics_->RecordStage(stage_, Clock::now() - start_);
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    QueryMetrics* metrics_;
+    QueryStage stage_;
+    Clock::time_point start_;
+};
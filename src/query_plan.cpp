@@ -0,0 +1,65 @@
+#include "query_plan.h"
+
+
+// ------------------------------- Names ------------------------------- //
+
+std::string_view GetStrategyName(PlusStrategy strategy)
+{
+    switch (strategy)
+    {
+    case PlusStrategy::TERM_AT_A_TIME:
+        return "term_at_a_time";
+    case PlusStrategy::DOCUMENT_AT_A_TIME:
+        return "document_at_a_time";
+    case PlusStrategy::INTERSECTION:
+        return "intersection";
+    case PlusStrategy::IMPACT_ORDERED:
+        return "impact_ordered";
+    }
+    return "unknown";
+}
+
+std::string_view GetStrategyName(MinusStrategy strategy)
+{
+    switch (strategy)
+    {
+    case MinusStrategy::NONE:
+        return "none";
+    case MinusStrategy::MINUS_FIRST:
+        return "minus_first";
+    case MinusStrategy::MINUS_PROBE:
+        return "minus_probe";
+    }
+    return "unknown";
+}
+
+
+// ------------------------------- Output ------------------------------- //
+
+std::ostream& operator<<(std::ostream& out, const QueryPlanInfo& plan)
+{
+    const auto write_terms = [&out](const std::vector<PlannedTerm>& terms)
+    {
+        for (const PlannedTerm& term : terms)
+        {
+            out << ' ' << term.word << "(df=" << term.document_freq << ", weight=" << term.weight << (term.is_dropped ? ", dropped)" : ")");
+        }
+        out << '\n';
+    };
+
+    out << "plus: " << GetStrategyName(plan.plus_strategy) << ", cost " << plan.plus_cost << '\n';
+    out << "  words:";
+    write_terms(plan.plus_terms);
+    if (plan.expanded_word_count > 0)
+    {
+        out << "  expanded words: " << plan.expanded_word_count << '\n';
+    }
+    out << "minus: " << GetStrategyName(plan.minus_strategy) << ", cost " << plan.minus_cost << '\n';
+    if (!plan.minus_terms.empty())
+    {
+        out << "  words:";
+        write_terms(plan.minus_terms);
+    }
+    out << "estimated cost: " << plan.GetEstimatedCost() << '\n';
+    return out;
+}
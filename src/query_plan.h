@@ -0,0 +1,68 @@
+#pragma once
+
+// QueryPlan - how the search evaluates a query (see SearchServer::Explain)
+// Statistics of every word of the query are resolved once. Plus-words of zero weight (IDF of a word contained
+// in every document) add nothing to relevance, so they are not scanned: their documents are added with zero relevance
+// only when there are too few documents with positive relevance to fill the result.
+// Strategies are chosen by the estimated cost in postings visited with the document frequencies of the words:
+//   TERM_AT_A_TIME - posting lists one by one, relevance is accumulated in a map by document
+//   DOCUMENT_AT_A_TIME - posting lists are merged by document, relevance of a document is complete when it is left
+//   INTERSECTION - documents of required words and phrases are intersected from the shortest list, then only they are scored
+//   IMPACT_ORDERED - tiers of impact-ordered postings with early termination (FindTopDocuments of TF-IDF)
+//   MINUS_FIRST - documents of minus-words are collected into a bitmap before scanning
+//   MINUS_PROBE - posting lists of minus-words are searched for every scanned posting, when they are longer than the scan
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class PlusStrategy
+{
+    TERM_AT_A_TIME,
+    DOCUMENT_AT_A_TIME,
+    INTERSECTION,
+    IMPACT_ORDERED,
+};
+
+enum class MinusStrategy
+{
+    NONE,
+    MINUS_FIRST,
+    MINUS_PROBE,
+};
+
+// Names of strategies for reports
+std::string_view GetStrategyName(PlusStrategy strategy);
+std::string_view GetStrategyName(MinusStrategy strategy);
+
+// Word of the query with its statistics
+struct PlannedTerm
+{
+    std::string word;
+    size_t document_freq = 0;
+    double weight = 0.0;
+    bool is_dropped = false;    // not scanned: not in the index or of zero weight
+};
+
+struct QueryPlanInfo
+{
+    PlusStrategy plus_strategy = PlusStrategy::TERM_AT_A_TIME;
+    MinusStrategy minus_strategy = MinusStrategy::NONE;
+    std::vector<PlannedTerm> plus_terms;
+    std::vector<PlannedTerm> minus_terms;
+    size_t expanded_word_count = 0;     // words of prefixes and fuzzy words, always scored term at a time
+
+    // Estimated postings visited
+    double plus_cost = 0.0;
+    double minus_cost = 0.0;
+
+    double GetEstimatedCost() const
+    {
+        return plus_cost + minus_cost;
+    }
+};
+
+// Plan in a human-readable form, one line per part
+std::ostream& operator<<(std::ostream& out, const QueryPlanInfo& plan);
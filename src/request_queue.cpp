@@ -1,9 +1,22 @@
 #include "request_queue.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    const uint64_t COUNT_MASK = 0xFFFFFFFFu;
+}
+
 // ------------------------------- Constructors ------------------------------- //
 
- RequestQueue::RequestQueue(const SearchServer& search_server)
-    :server_(search_server)
+RequestQueue::RequestQueue(const SearchServer& search_server, std::chrono::seconds window)
+    : server_(search_server)
+    , start_(Clock::now())
+    , window_(window.count() > 0 
+        ? static_cast<uint32_t>(window.count()) 
+        : throw std::invalid_argument("Error! Window of the request queue must be positive!"))
+    , buckets_(window_)
 {
 }
 
@@ -11,49 +24,177 @@
 
 // ------------------------------- Interface (public) ------------------------------- //
 
-template <typename DocumentPredicate>
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) 
+std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status)
 {
-    std::vector<Document> found = server_.FindTopDocuments(raw_query, document_predicate);
-    
-    QueryResult result = {(found.empty()) ? (true) : (false)};
-    requests_.push_back(result);
-    if (requests_.size() > sec_in_day_) 
+    DocumentFilter filter;
+    filter.status = status;
+    return AddFindRequest(raw_query, filter);
+}
+
+std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
+{
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
+}
+
+void RequestQueue::AddRequest(bool has_result, Clock::duration latency, Clock::time_point time)
+{
+    const uint32_t second = GetSecond(time);
+    Advance(second);
+    Bucket& bucket = buckets_[second % window_];
+
+    // Index of the highest bit of the latency in microseconds
+    uint64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    size_t latency_bucket = 0;
+    while (microseconds > 0 && latency_bucket + 1 < LATENCY_BUCKET_COUNT)
+    {
+        microseconds >>= 1;
+        ++latency_bucket;
+    }
+
+    Increment(bucket.total, totals_.total, second);
+    if (!has_result)
     {
-        requests_.pop_front();
+        Increment(bucket.no_result, totals_.no_result, second);
     }
+    Increment(bucket.latencies[latency_bucket], totals_.latencies[latency_bucket], second);
 
-    return found;
+    // The window may have moved past the second meanwhile, and the expiration could miss these counts
+    if (latest_second_.load() - second >= window_)
+    {
+        Expire(bucket.total, totals_.total, second);
+        Expire(bucket.no_result, totals_.no_result, second);
+        Expire(bucket.latencies[latency_bucket], totals_.latencies[latency_bucket], second);
+    }
+}
+
+int RequestQueue::GetNoResultRequests(Clock::time_point time) const
+{
+    Advance(GetSecond(time));
+    return static_cast<int>(std::max<int64_t>(totals_.no_result.load(), 0));
+}
+
+int RequestQueue::GetTotalRequests(Clock::time_point time) const
+{
+    Advance(GetSecond(time));
+    return static_cast<int>(std::max<int64_t>(totals_.total.load(), 0));
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) 
+RequestQueue::LatencyHistogram RequestQueue::GetLatencyHistogram(Clock::time_point time) const
 {
-    return AddFindRequest(raw_query, 
-        [status](int document_id, DocumentStatus document_status, int rating) 
+    Advance(GetSecond(time));
+    LatencyHistogram histogram{};
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+    {
+        histogram[i] = static_cast<uint64_t>(std::max<int64_t>(totals_.latencies[i].load(), 0));
+    }
+    return histogram;
+}
+
+std::chrono::microseconds RequestQueue::GetLatencyQuantile(double quantile, Clock::time_point time) const
+{
+    const LatencyHistogram histogram = GetLatencyHistogram(time);
+    uint64_t total = 0;
+    for (const uint64_t count : histogram)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+
+    // Requests with latency not above the answer
+    const uint64_t rank = static_cast<uint64_t>(quantile * total);
+    uint64_t count = 0;
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+    {
+        count += histogram[i];
+        if (count > rank || count == total)
         {
-            return document_status == status;
-        });
+            return std::chrono::microseconds(uint64_t{1} << i);
+        }
+    }
+    return std::chrono::microseconds(0);
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) 
+
+// ------------------------------- Private ------------------------------- //
+
+uint32_t RequestQueue::GetSecond(Clock::time_point time) const
 {
-    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
+    if (time < start_)
+    {
+        return 1;
+    }
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(time - start_).count()) + 1;
 }
 
-int RequestQueue::GetNoResultRequests() const 
+void RequestQueue::Increment(std::atomic<uint64_t>& counter, std::atomic<int64_t>& total, uint32_t second)
 {
-    int noresult = 0;
-    for (auto it = requests_.begin(); it != requests_.end(); ++it) 
+    uint64_t value = counter.load();
+    while (true)
     {
-        if ((*it).isEmpty) 
+        const uint32_t counter_second = static_cast<uint32_t>(value >> 32);
+        if (counter_second > second)
         {
-            ++noresult;
+            // The bucket already counts a later second, the request is out of the window
+            return;
+        }
+        const uint64_t next = counter_second == second ? value + 1 : (uint64_t{second} << 32) | 1u;
+        if (counter.compare_exchange_weak(value, next))
+        {
+            // The count of an older second is taken out of the counter here
+            const int64_t taken = counter_second == second ? 0 : static_cast<int64_t>(value & COUNT_MASK);
+            total.fetch_add(1 - taken);
+            return;
         }
     }
-    return noresult;
 }
 
+void RequestQueue::Expire(std::atomic<uint64_t>& counter, std::atomic<int64_t>& total, uint32_t second) const
+{
+    // The counter gets the next second of the bucket with no requests, so late requests of the second are dropped
+    uint64_t value = counter.load();
+    while (static_cast<uint32_t>(value >> 32) <= second)
+    {
+        if (counter.compare_exchange_weak(value, uint64_t{second + window_} << 32))
+        {
+            total.fetch_sub(static_cast<int64_t>(value & COUNT_MASK));
+            return;
+        }
+    }
+}
+
+void RequestQueue::Advance(uint32_t second) const
+{
+    uint32_t latest = latest_second_.load();
+    while (second > latest)
+    {
+        if (!latest_second_.compare_exchange_weak(latest, second))
+        {
+            continue;
+        }
 
-// explicit instanciation
-template std::vector<Document> RequestQueue::AddFindRequest(const std::string&,
-    std::function<bool (int, DocumentStatus, int)>);
+        // Seconds (latest - window, second - window] leave the window, of them only the last window ones have buckets
+        if (second > window_)
+        {
+            const uint32_t last = second - window_;
+            uint32_t first = latest > window_ ? latest - window_ + 1 : 1;
+            if (last - first >= window_ && last >= first)
+            {
+                first = last - window_ + 1;
+            }
+            for (uint32_t expired = first; expired <= last; ++expired)
+            {
+                Bucket& bucket = buckets_[expired % window_];
+                Expire(bucket.total, totals_.total, expired);
+                Expire(bucket.no_result, totals_.no_result, expired);
+                for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+                {
+                    Expire(bucket.latencies[i], totals_.latencies[i], expired);
+                }
+            }
+        }
+        return;
+    }
+}
@@ -2,34 +2,104 @@
 
 // RequestQueue - class, whose task is to keep track of incoming requests
 // Requests have statuses (completed / unfulfilled)
-// Requests that have not been fulfilled for too long are sent into oblivion (lol), giving way to new ones 
+// Statistics is kept for a sliding window of time (DEFAULT_WINDOW_SECONDS = 1440 seconds, i.e. 24 minutes, by default),
+// older requests are forgotten. The queue used to keep the last 1440 requests whatever their time, so with the default
+// window GetNoResultRequests counts the requests of the last 24 minutes instead of the last 1440 requests
+// The window is a ring of per-second buckets of atomic counters, so requests may be added from many threads
+// without locks. Running totals of the window are kept beside the buckets: a request is added to them,
+// and the counts of a bucket are subtracted when its second leaves the window, so the statistics is read in O(1)
 
-#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
-#include <deque>
+#include <vector>
 
 #include "search_server.h"
 
 
-class RequestQueue 
+class RequestQueue
 {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    using Clock = std::chrono::steady_clock;
+
+    // Bucket 0 of the latency histogram - under 1 microsecond,
+    // bucket i - from 2^(i-1) to 2^i microseconds, the last bucket - everything longer
+    static const size_t LATENCY_BUCKET_COUNT = 32;
+    using LatencyHistogram = std::array<uint64_t, LATENCY_BUCKET_COUNT>;
 
-    // Lets make "wrappers" for all search methods to save results for our statistics 
+    explicit RequestQueue(const SearchServer& search_server, std::chrono::seconds window = std::chrono::seconds(DEFAULT_WINDOW_SECONDS));
+
+    // Lets make "wrappers" for all search methods to save results for our statistics
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate)
+    {
+        const Clock::time_point start = Clock::now();
+        std::vector<Document> found = server_.FindTopDocuments(raw_query, document_predicate);
+        const Clock::time_point finish = Clock::now();
+
+        AddRequest(!found.empty(), finish - start, finish);
+        return found;
+    }
 
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
 
     std::vector<Document> AddFindRequest(const std::string& raw_query);
-    int GetNoResultRequests() const;
+
+    // Register a request made without the queue (for example, by ProcessQueries)
+    void AddRequest(bool has_result, Clock::duration latency, Clock::time_point time = Clock::now());
+
+    // Statistics of the requests in the window ending at time
+    // The window never moves back: for a time before the latest request or read it ends at that latest time
+    int GetNoResultRequests(Clock::time_point time = Clock::now()) const;
+    int GetTotalRequests(Clock::time_point time = Clock::now()) const;
+    LatencyHistogram GetLatencyHistogram(Clock::time_point time = Clock::now()) const;
+
+    // Upper bound of the latency bucket containing the quantile (0.5 - median, 0.99 - 99th percentile)
+    std::chrono::microseconds GetLatencyQuantile(double quantile, Clock::time_point time = Clock::now()) const;
+
 private:
-    struct QueryResult 
+    // Default length of the window in seconds
+    static constexpr int DEFAULT_WINDOW_SECONDS = 1440;
+
+    // Counters of requests made during one second
+    // Every counter keeps the number of the second in the high 32 bits and the count in the low 32 bits,
+    // so a counter of an old second is reset by the first increment in a new second without any lock
+    struct Bucket
     {
-        bool isEmpty;
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> no_result;
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT> latencies;
     };
+
+    // Counts of all buckets of the window. A count taken out of a counter of a bucket (by a new second of the bucket
+    // or by expiration) is subtracted by the thread which took it, so the totals are exact when no request is being added
+    struct Totals
+    {
+        std::atomic<int64_t> total{0};
+        std::atomic<int64_t> no_result{0};
+        std::array<std::atomic<int64_t>, LATENCY_BUCKET_COUNT> latencies{};
+    };
+
+    // Number of the second since creation of the queue, starting from 1
+    uint32_t GetSecond(Clock::time_point time) const;
+
+    // Count the request in the counter of the bucket and in the total
+    void Increment(std::atomic<uint64_t>& counter, std::atomic<int64_t>& total, uint32_t second);
+
+    // Take the count of the second out of the counter, if the counter still has it (or an older one)
+    void Expire(std::atomic<uint64_t>& counter, std::atomic<int64_t>& total, uint32_t second) const;
+
+    // Move the end of the window to the second, expiring the seconds which leave it
+    void Advance(uint32_t second) const;
+
     const SearchServer& server_;
-    std::deque<QueryResult> requests_;
-    const static int sec_in_day_ = 1440;
-};
\ No newline at end of file
+    const Clock::time_point start_;
+    const uint32_t window_;
+
+    // Buckets and totals are changed by reads too, when the window moves
+    mutable std::vector<Bucket> buckets_;
+    mutable Totals totals_;
+    mutable std::atomic<uint32_t> latest_second_{0};
+};
@@ -0,0 +1,263 @@
+#include "roaring_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    // Chunk is 65536 numbers with the same high 16 bits
+    const size_t BITSET_WORDS = 65536 / 64;
+
+    // Array with more values is larger than a bitset
+    const size_t MAX_ARRAY_SIZE = 4096;
+
+    // Values of the set bits in ascending order
+    std::vector<uint16_t> BitsToValues(const uint64_t* bits)
+    {
+        std::vector<uint16_t> values;
+        for (size_t i = 0; i < BITSET_WORDS; ++i)
+        {
+            for (uint64_t word = bits[i]; word != 0; word &= word - 1)
+            {
+                values.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+            }
+        }
+        return values;
+    }
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+RoaringBitmap RoaringBitmap::FromSorted(const std::vector<uint32_t>& values)
+{
+    RoaringBitmap bitmap;
+    for (size_t begin = 0; begin < values.size();)
+    {
+        const uint16_t key = static_cast<uint16_t>(values[begin] >> 16);
+        size_t end = begin;
+        Container container;
+        while (end < values.size() && (values[end] >> 16) == key)
+        {
+            container.values.push_back(static_cast<uint16_t>(values[end]));
+            ++end;
+        }
+        container.cardinality = static_cast<uint32_t>(end - begin);
+        container.Optimize();
+
+        bitmap.keys_.push_back(key);
+        bitmap.containers_.push_back(std::move(container));
+        begin = end;
+    }
+    return bitmap;
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const
+{
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    return it != keys_.end() && *it == key
+        && containers_[it - keys_.begin()].Contains(static_cast<uint16_t>(value));
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other)
+{
+    std::vector<uint16_t> keys;
+    std::vector<Container> containers;
+    keys.reserve(keys_.size() + other.keys_.size());
+    containers.reserve(keys_.size() + other.keys_.size());
+
+    // Merge chunks by keys
+    size_t i = 0, j = 0;
+    while (i < keys_.size() || j < other.keys_.size())
+    {
+        if (j == other.keys_.size() || (i < keys_.size() && keys_[i] < other.keys_[j]))
+        {
+            keys.push_back(keys_[i]);
+            containers.push_back(std::move(containers_[i++]));
+        }
+        else if (i == keys_.size() || other.keys_[j] < keys_[i])
+        {
+            keys.push_back(other.keys_[j]);
+            containers.push_back(other.containers_[j++]);
+        }
+        else
+        {
+            keys.push_back(keys_[i]);
+            containers.push_back(Unite(containers_[i++], other.containers_[j++]));
+        }
+    }
+
+    keys_ = std::move(keys);
+    containers_ = std::move(containers);
+    return *this;
+}
+
+size_t RoaringBitmap::GetCardinality() const
+{
+    size_t cardinality = 0;
+    for (const Container& container : containers_)
+    {
+        cardinality += container.cardinality;
+    }
+    return cardinality;
+}
+
+size_t RoaringBitmap::GetMemoryUsage() const
+{
+    size_t bytes = keys_.capacity() * sizeof(uint16_t) + containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_)
+    {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+
+// ------------------------------- Container ------------------------------- //
+
+bool RoaringBitmap::Container::Contains(uint16_t value) const
+{
+    switch (type)
+    {
+    case Type::ARRAY:
+        return std::binary_search(values.begin(), values.end(), value);
+    case Type::BITSET:
+        return (bits[value / 64] >> (value % 64)) & 1u;
+    case Type::RUN:
+    {
+        // Last run starting not after the value
+        size_t first = 0, last = values.size() / 2;
+        while (first < last)
+        {
+            const size_t middle = (first + last) / 2;
+            if (values[middle * 2] <= value)
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+        return first > 0 && value <= values[first * 2 - 1];
+    }
+    }
+    return false;
+}
+
+void RoaringBitmap::Container::OrInto(uint64_t* target) const
+{
+    switch (type)
+    {
+    case Type::ARRAY:
+        for (const uint16_t value : values)
+        {
+            target[value / 64] |= uint64_t{1} << (value % 64);
+        }
+        break;
+    case Type::BITSET:
+        for (size_t i = 0; i < BITSET_WORDS; ++i)
+        {
+            target[i] |= bits[i];
+        }
+        break;
+    case Type::RUN:
+        for (size_t i = 0; i < values.size(); i += 2)
+        {
+            for (uint32_t value = values[i]; value <= values[i + 1]; ++value)
+            {
+                target[value / 64] |= uint64_t{1} << (value % 64);
+            }
+        }
+        break;
+    }
+}
+
+void RoaringBitmap::Container::Optimize()
+{
+    // Sorted values of the container
+    std::vector<uint16_t> sorted;
+    if (type == Type::ARRAY)
+    {
+        sorted = std::move(values);
+    }
+    else
+    {
+        std::vector<uint64_t> target(BITSET_WORDS, 0);
+        OrInto(target.data());
+        sorted = BitsToValues(target.data());
+    }
+    cardinality = static_cast<uint32_t>(sorted.size());
+
+    size_t run_count = 0;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        if (i == 0 || sorted[i] != sorted[i - 1] + 1)
+        {
+            ++run_count;
+        }
+    }
+
+    // Sizes of the containers in bytes
+    const size_t array_size = sorted.size() * sizeof(uint16_t);
+    const size_t bitset_size = BITSET_WORDS * sizeof(uint64_t);
+    const size_t run_size = run_count * 2 * sizeof(uint16_t);
+
+    values.clear();
+    bits.clear();
+    if (run_size < std::min(array_size, bitset_size))
+    {
+        type = Type::RUN;
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            if (i == 0 || sorted[i] != sorted[i - 1] + 1)
+            {
+                values.push_back(sorted[i]);
+                values.push_back(sorted[i]);
+            }
+            else
+            {
+                values.back() = sorted[i];
+            }
+        }
+    }
+    else if (sorted.size() <= MAX_ARRAY_SIZE)
+    {
+        type = Type::ARRAY;
+        values = std::move(sorted);
+    }
+    else
+    {
+        type = Type::BITSET;
+        bits.assign(BITSET_WORDS, 0);
+        for (const uint16_t value : sorted)
+        {
+            bits[value / 64] |= uint64_t{1} << (value % 64);
+        }
+    }
+    values.shrink_to_fit();
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+RoaringBitmap::Container RoaringBitmap::Unite(const Container& lhs, const Container& rhs)
+{
+    Container result;
+    if (lhs.type == Container::Type::ARRAY && rhs.type == Container::Type::ARRAY)
+    {
+        std::set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(),
+            std::back_inserter(result.values));
+    }
+    else
+    {
+        result.type = Container::Type::BITSET;
+        result.bits.assign(BITSET_WORDS, 0);
+        lhs.OrInto(result.bits.data());
+        rhs.OrInto(result.bits.data());
+    }
+    result.Optimize();
+    return result;
+}
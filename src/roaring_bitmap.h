@@ -0,0 +1,71 @@
+#pragma once
+
+// RoaringBitmap - compressed set of internal numbers of documents
+// Numbers are split by the high 16 bits into chunks, every chunk is stored in the smallest of containers:
+//   array  - sorted low 16 bits, for sparse chunks (up to 4096 values)
+//   bitset - 65536 bits, for dense chunks
+//   run    - sorted runs [start, last] of consecutive values, for chunks of long ranges
+// Contains is a binary search of the chunk plus a test in its container
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RoaringBitmap
+{
+public:
+    // Build from sorted numbers without duplicates (posting list of a word)
+    static RoaringBitmap FromSorted(const std::vector<uint32_t>& values);
+
+    bool Contains(uint32_t value) const;
+
+    // Union with other bitmap
+    RoaringBitmap& operator|=(const RoaringBitmap& other);
+
+    bool IsEmpty() const
+    {
+        return keys_.empty();
+    }
+
+    // Amount of numbers in the set
+    size_t GetCardinality() const;
+
+    // Bytes used by the containers
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Container
+    {
+        enum class Type : uint8_t
+        {
+            ARRAY,
+            BITSET,
+            RUN
+        };
+
+        Type type = Type::ARRAY;
+
+        // ARRAY: sorted values, RUN: pairs of start and last value of runs
+        std::vector<uint16_t> values;
+
+        // BITSET: BITSET_WORDS words
+        std::vector<uint64_t> bits;
+
+        uint32_t cardinality = 0;
+
+        bool Contains(uint16_t value) const;
+
+        // Set bits of the container in bits (BITSET_WORDS words)
+        void OrInto(uint64_t* bits) const;
+
+        // Convert to the smallest container of the same values
+        void Optimize();
+    };
+
+    // Union of two containers of the same chunk
+    static Container Unite(const Container& lhs, const Container& rhs);
+
+    // High 16 bits of numbers of the chunks, sorted
+    std::vector<uint16_t> keys_;
+    std::vector<Container> containers_;
+};
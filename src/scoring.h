@@ -0,0 +1,55 @@
+#pragma once
+
+// Scoring policies - compile-time parameters of the search path
+// A scorer is a class with static functions only, so every instantiation of the search
+// is inlined into the loop over posting lists without any virtual calls:
+//   ComputeWeight(statistics, document_freq) - weight of a word, calculated once per word of the query
+//   Score(weight, term_freq, document_length, statistics) - contribution of the word to the relevance
+//   USES_DOCUMENT_LENGTH - if false, the search doesn't load lengths of documents
+
+#include <cmath>
+#include <cstddef>
+
+// Statistics of the whole collection of documents
+struct CollectionStatistics
+{
+    size_t document_count = 0;
+    double average_document_length = 0.0;
+};
+
+// TF-IDF: relevance = TF * log(N / DF)
+struct TfIdfScorer
+{
+    static constexpr bool USES_DOCUMENT_LENGTH = false;
+
+    static double ComputeWeight(const CollectionStatistics& statistics, size_t document_freq)
+    {
+        return std::log(statistics.document_count * 1.0 / document_freq);
+    }
+
+    static double Score(double weight, double term_freq, [[maybe_unused]] int document_length, [[maybe_unused]] const CollectionStatistics& statistics)
+    {
+        return term_freq * weight;
+    }
+};
+
+// Okapi BM25 with k1 = 1.2 and b = 0.75
+// TF of the index is a share of the word in the document, so count of the word is TF * length of the document
+struct Bm25Scorer
+{
+    static constexpr bool USES_DOCUMENT_LENGTH = true;
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+
+    static double ComputeWeight(const CollectionStatistics& statistics, size_t document_freq)
+    {
+        return std::log(1.0 + (statistics.document_count - document_freq + 0.5) / (document_freq + 0.5));
+    }
+
+    static double Score(double weight, double term_freq, int document_length, const CollectionStatistics& statistics)
+    {
+        const double word_count = term_freq * document_length;
+        const double length_norm = 1.0 - B + B * document_length / statistics.average_document_length;
+        return weight * word_count * (K1 + 1.0) / (word_count + K1 * length_norm);
+    }
+};
@@ -0,0 +1,173 @@
+#include "search_results.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    // Pages are small, so the sorted prefix grows at least by this amount
+    // to avoid rescanning the unsorted tail for every few documents
+    const size_t MIN_SORT_STEP = 32;
+
+    // Larger tops are selected by radix select, smaller ones by a heap
+    const size_t MAX_HEAP_SELECT_COUNT = 64;
+}
+
+void KeepTopDocuments(std::vector<Document>& documents, size_t count)
+{
+    count = std::min(count, documents.size());
+    if (count == 0)
+    {
+        documents.clear();
+        return;
+    }
+
+    // Keys and places of the top documents
+    std::vector<std::pair<uint64_t, size_t>> top;
+    top.reserve(count);
+    if (count <= MAX_HEAP_SELECT_COUNT)
+    {
+        // Min-heap of the top: a key gets into it only if it is larger than the smallest key of the top,
+        // of equal keys the last one is the smallest, so documents with equal keys keep their order
+        const auto is_greater = [](const std::pair<uint64_t, size_t>& lhs, const std::pair<uint64_t, size_t>& rhs)
+        {
+            return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+        };
+        // Quantized relevance below this can't make a key larger than the smallest one of the top, it is checked before the key
+        double min_relevance = std::numeric_limits<double>::lowest();
+        for (size_t i = 0; i < documents.size(); ++i)
+        {
+            if (documents[i].relevance * (1.0 / RELEVANCE_TOLERANCE) < min_relevance)
+            {
+                continue;
+            }
+            const uint64_t key = GetSortKey(documents[i]);
+            if (top.size() < count)
+            {
+                top.push_back({key, i});
+                std::push_heap(top.begin(), top.end(), is_greater);
+            }
+            else if (key > top.front().first)
+            {
+                std::pop_heap(top.begin(), top.end(), is_greater);
+                top.back() = {key, i};
+                std::push_heap(top.begin(), top.end(), is_greater);
+            }
+            const uint64_t min_top_relevance = top.front().first >> SORT_KEY_RATING_BITS;
+            if (top.size() == count && min_top_relevance > 0)
+            {
+                min_relevance = static_cast<double>(min_top_relevance) - 1.0;
+            }
+        }
+        std::sort(top.begin(), top.end(), is_greater);
+    }
+    else
+    {
+        std::vector<uint64_t> keys(documents.size());
+        for (size_t i = 0; i < documents.size(); ++i)
+        {
+            keys[i] = GetSortKey(documents[i]);
+        }
+
+        // Key of the count-th document: rank is its place among the candidates, which have the found prefix of the key
+        const std::vector<uint64_t>* candidates = &keys;
+        std::vector<uint64_t> prefix_candidates;
+        uint64_t threshold = 0;
+        size_t rank = count;
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            std::array<size_t, 256> histogram = {};
+            for (const uint64_t key : *candidates)
+            {
+                ++histogram[(key >> shift) & 0xFF];
+            }
+            size_t byte = 255;
+            while (histogram[byte] < rank)
+            {
+                rank -= histogram[byte];
+                --byte;
+            }
+            threshold |= static_cast<uint64_t>(byte) << shift;
+            if (histogram[byte] == candidates->size())
+            {
+                continue;
+            }
+            std::vector<uint64_t> next_candidates;
+            next_candidates.reserve(histogram[byte]);
+            for (const uint64_t key : *candidates)
+            {
+                if (((key >> shift) & 0xFF) == byte)
+                {
+                    next_candidates.push_back(key);
+                }
+            }
+            prefix_candidates = std::move(next_candidates);
+            candidates = &prefix_candidates;
+        }
+
+        // Documents with larger keys and the first rank documents with the key of the threshold
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] > threshold || (keys[i] == threshold && rank > 0))
+            {
+                rank -= keys[i] == threshold;
+                top.push_back({keys[i], i});
+            }
+        }
+        std::stable_sort(top.begin(), top.end(), [](const std::pair<uint64_t, size_t>& lhs, const std::pair<uint64_t, size_t>& rhs)
+            {
+                return lhs.first > rhs.first;
+            });
+    }
+
+    std::vector<Document> top_documents;
+    top_documents.reserve(count);
+    for (const auto& [key, index] : top)
+    {
+        top_documents.push_back(documents[index]);
+    }
+    documents = std::move(top_documents);
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+SearchResults::SearchResults(std::vector<Document> documents, uint64_t index_version)
+    : documents_(std::move(documents)), index_version_(index_version)
+{}
+
+std::vector<Document> SearchResults::GetPage(size_t offset, size_t limit) const
+{
+    if (offset >= documents_.size())
+    {
+        return {};
+    }
+    const size_t last = offset + std::min(limit, documents_.size() - offset);
+    SortTop(last);
+    return std::vector<Document>(documents_.begin() + offset, documents_.begin() + last);
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+const Document& SearchResults::GetDocument(size_t index) const
+{
+    SortTop(index + 1);
+    return documents_[index];
+}
+
+void SearchResults::SortTop(size_t count) const
+{
+    if (count <= sorted_count_)
+    {
+        return;
+    }
+    count = std::min(std::max(count, sorted_count_ + MIN_SORT_STEP), documents_.size());
+
+    // Documents after the sorted prefix are less relevant than the prefix,
+    // so the next documents are the top of the tail
+    std::partial_sort(documents_.begin() + sorted_count_, documents_.begin() + count, documents_.end(), IsMoreRelevant);
+    sorted_count_ = count;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+// SearchResults - all documents found by a query, sorted lazily
+// Only the requested top of the documents is sorted: a page [offset, offset + limit) sorts documents
+// up to offset + limit, the next pages continue from the already sorted prefix.
+// Iterators are random access and sort on dereference, so Paginate(results, page_size) splits
+// the results into pages without sorting them, and every page is sorted when it is read
+// Reading sorts the documents inside, so reading the same results from several threads needs a lock
+
+#include "document.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// Step of quantization of relevance in the order of the result
+const double RELEVANCE_TOLERANCE = 1e-6;
+
+// Bits of the sort key: quantized relevance in the high bits, rating in the low bits
+const int SORT_KEY_RATING_BITS = 24;
+const uint64_t SORT_KEY_MAX_RELEVANCE = (uint64_t{1} << (64 - SORT_KEY_RATING_BITS)) - 1;
+
+// Sort key of a document, a larger key is more relevant
+// Relevance is rounded to RELEVANCE_TOLERANCE, so relevance closer than the tolerance is usually equal and rating decides,
+// and documents ordered otherwise than by exact relevance differ less than the tolerance.
+// Relevance is clamped to [0, about 1.1e6] and rating to [-2^23, 2^23), keys of documents beyond are equal in that part
+inline uint64_t GetSortKey(const Document& document)
+{
+    const double relevance = std::min(std::max(document.relevance * (1.0 / RELEVANCE_TOLERANCE) + 0.5, 0.0),
+        static_cast<double>(SORT_KEY_MAX_RELEVANCE));
+    const int64_t rating_bound = int64_t{1} << (SORT_KEY_RATING_BITS - 1);
+    const int64_t rating = std::clamp<int64_t>(document.rating, -rating_bound, rating_bound - 1) + rating_bound;
+    // Relevance fits into int64_t, its conversion is one instruction unlike the one to uint64_t
+    return (static_cast<uint64_t>(static_cast<int64_t>(relevance)) << SORT_KEY_RATING_BITS) | static_cast<uint64_t>(rating);
+}
+
+// Order of documents in the result: by relevance, equal relevance - by rating
+inline bool IsMoreRelevant(const Document& lhs, const Document& rhs)
+{
+    return GetSortKey(lhs) > GetSortKey(rhs);
+}
+
+// Leave count most relevant documents in the order of relevance, documents with equal keys keep their order
+// Keys are compared as integers without branches on the tolerance. A small top is kept in a heap, which most keys
+// don't enter after one comparison. For a large top the key of its last document is found by radix select:
+// byte by byte from the highest one, only keys with the found prefix are counted, so the candidates shrink quickly
+void KeepTopDocuments(std::vector<Document>& documents, size_t count);
+
+class SearchResults
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator(const SearchResults* results, size_t index)
+            : results_(results), index_(index)
+        {}
+
+        reference operator*() const
+        {
+            return results_->GetDocument(index_);
+        }
+        pointer operator->() const
+        {
+            return &results_->GetDocument(index_);
+        }
+
+        reference operator[](difference_type n) const
+        {
+            return results_->GetDocument(index_ + n);
+        }
+
+        Iterator& operator++()
+        {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            const Iterator old = *this;
+            ++index_;
+            return old;
+        }
+        Iterator& operator--()
+        {
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            const Iterator old = *this;
+            --index_;
+            return old;
+        }
+        Iterator& operator+=(difference_type n)
+        {
+            index_ += n;
+            return *this;
+        }
+        Iterator& operator-=(difference_type n)
+        {
+            index_ -= n;
+            return *this;
+        }
+        Iterator operator+(difference_type n) const
+        {
+            return Iterator(results_, index_ + n);
+        }
+        friend Iterator operator+(difference_type n, const Iterator& it)
+        {
+            return it + n;
+        }
+        Iterator operator-(difference_type n) const
+        {
+            return Iterator(results_, index_ - n);
+        }
+        difference_type operator-(const Iterator& other) const
+        {
+            return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return index_ == other.index_;
+        }
+        bool operator!=(const Iterator& other) const
+        {
+            return index_ != other.index_;
+        }
+        bool operator<(const Iterator& other) const
+        {
+            return index_ < other.index_;
+        }
+        bool operator>(const Iterator& other) const
+        {
+            return index_ > other.index_;
+        }
+        bool operator<=(const Iterator& other) const
+        {
+            return index_ <= other.index_;
+        }
+        bool operator>=(const Iterator& other) const
+        {
+            return index_ >= other.index_;
+        }
+
+    private:
+        const SearchResults* results_;
+        size_t index_;
+    };
+
+    SearchResults() = default;
+
+    // Documents in any order, version of the index they were found in
+    SearchResults(std::vector<Document> documents, uint64_t index_version);
+
+    // Documents [offset, offset + limit) in the order of relevance
+    std::vector<Document> GetPage(size_t offset, size_t limit) const;
+
+    // Amount of found documents
+    size_t size() const
+    {
+        return documents_.size();
+    }
+
+    // Version of the index of the server when the results were found
+    // The results don't see documents added or removed after it
+    uint64_t GetIndexVersion() const
+    {
+        return index_version_;
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(this, 0);
+    }
+    Iterator end() const
+    {
+        return Iterator(this, documents_.size());
+    }
+
+private:
+    // Document at the position index in the order of relevance
+    const Document& GetDocument(size_t index) const;
+
+    // Sort documents until count first of them are in the order of relevance
+    void SortTop(size_t count) const;
+
+    // Prefix of sorted_count_ documents is sorted and contains the most relevant documents
+    mutable std::vector<Document> documents_;
+    mutable size_t sorted_count_ = 0;
+
+    uint64_t index_version_ = 0;
+};
@@ -16,7 +16,7 @@ std::vector<std::string_view> SPI(std::string_view text) {
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
 {
     // Verifing document id
-    if (document_id < 0 || documents_extra_.count(document_id)) 
+    if (document_id < 0 || documents_.Contains(document_id)) 
     {
         throw std::invalid_argument("Error! Invalid id of document!");
     }
@@ -25,44 +25,121 @@ void SearchServer::AddDocument(int document_id, const std::string_view document,
         throw std::invalid_argument("Error! Line has invalid symbols!");
     }
 
-    // Now we have stored strings and we can use string_view
-    const auto [it, _] = documents_extra_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, std::string(document) });
-
     // Saving document data without stop words
-    const auto words = SplitIntoWordsNoStop(it->second.content);
+    const auto words = SplitIntoWordsNoStop(document);
 
-    // Finding the fraction of 1 word in the document 
+    // Metadata of the document, the document gets the next internal number
     const int words_size = words.size();
-    const double inv_word_count = 1.0 / words_size;
+    const uint32_t number = documents_.Add(document_id, status, ComputeAverageRating(ratings), words_size, std::string(document));
+    total_word_count_ += words_size;
+
+    // Calculate words frequncies in the document
+    std::map<std::string_view, int> document_word_counts;
+    for (const std::string_view word : words)
+    {
+        ++document_word_counts[word];
+    }
 
     // Saving the data about the document in the required format (needed for TF-IDF) 
-    // And calculate words frequncies in the document
-    for (const auto word : words)
+    // Words are stored in the dictionary, so they outlive the content of the document
+    // Hash of a word is computed once for the dictionary and the posting lists
+    // The number is greater than numbers of all documents in the posting lists, so it is appended
+    std::vector<std::pair<std::string_view, int>> word_counts;
+    word_counts.reserve(document_word_counts.size());
+    for (const auto [word, count] : document_word_counts)
     {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
+        const size_t hash = HashTerm(word);
+        const std::string_view stored_word = term_dictionary_.Intern(word, hash);
+        const auto [postings_it, is_new_word] = word_to_postings_.try_emplace(stored_word, hash);
+        if (is_new_word)
+        {
+            postings_it->second.term_freqs = TermFreqColumn(options_.term_freq_precision);
+        }
+        postings_it->second.Append(number, count / static_cast<double>(words_size));
+        word_counts.push_back({stored_word, count});
     }
+    DropImpactOrderedPostings(word_counts);
 
-    // Calculate words frequncies in the document
-    std::set<std::string_view> unique_words(words.begin(), words.end());
-    for (const std::string_view word : unique_words)
+    // Words of the document in the forward index
+    if (options_.forward_index == ForwardIndexMode::FULL)
+    {
+        auto& word_freqs = document_to_word_freqs_[document_id];
+        for (const auto& [word, count] : word_counts)
+        {
+            word_freqs.emplace(word, count / static_cast<double>(words_size));
+        }
+    }
+    else if (options_.forward_index == ForwardIndexMode::COMPACT)
     {
-        document_to_word_freqs_[document_id].insert({word, 
-            std::count(words.begin(), words.end(), word) / static_cast<double>(words_size)});
+        document_terms_.resize(number + 1);
+        std::vector<uint32_t>& term_ids = document_terms_[number];
+        term_ids.reserve(word_counts.size());
+        for (const auto& [word, count] : word_counts)
+        {
+            term_ids.push_back(*term_dictionary_.FindId(word));
+        }
+        std::sort(term_ids.begin(), term_ids.end());
+    }
+
+    // Saving positions of words for phrase queries
+    if (options_.use_positional_index)
+    {
+        std::vector<std::pair<std::string_view, uint32_t>> word_positions;
+        uint32_t position = 0;
+        for (const std::string_view word : SPI(document))
+        {
+            if (word.empty())
+            {
+                continue;
+            }
+            if (!IsStopWord(word))
+            {
+                word_positions.push_back({term_dictionary_.Intern(word), position});
+            }
+            ++position;
+        }
+        positional_index_.AddDocument(number, word_positions);
     }
 
     // Loging the document
     document_ids_.insert(document_id);
     ++document_count_;
+    ++index_version_;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus document_status) const
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string>& queries) const
 {
-    return FindTopDocuments(std::execution::seq, raw_query, document_status);
+    ThreadPool& pool = GetThreadPool();
+    std::vector<std::vector<Document>> results(queries.size());
+    pool.ParallelFor(queries.size(), [this, &pool, &queries, &results](size_t i)
+        {
+            results[i] = FindTopDocumentsInPool<TfIdfScorer>(pool, queries[i], DocumentStatus::ACTUAL);
+        });
+    return results;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query) const
+ThreadPool& SearchServer::GetThreadPool() const
 {
-    return FindTopDocuments(std::execution::seq, raw_query);
+    std::call_once(thread_pool_flag_, [this]()
+        {
+            thread_pool_ = std::make_unique<ThreadPool>(options_.query_threads);
+        });
+    return *thread_pool_;
+}
+
+QueryMetricsSnapshot SearchServer::GetQueryMetrics() const
+{
+    return metrics_.GetSnapshot();
+}
+
+void SearchServer::WriteQueryMetrics(std::ostream& out) const
+{
+    WritePrometheusMetrics(out, metrics_.GetSnapshot());
+}
+
+uint64_t SearchServer::GetIndexVersion() const
+{
+    return index_version_;
 }
 
 int SearchServer::GetDocumentCount() const 
@@ -70,12 +147,12 @@ int SearchServer::GetDocumentCount() const
     return document_count_;
 }
 
-std::set<int>::const_iterator SearchServer::begin() const
+std::pmr::set<int>::const_iterator SearchServer::begin() const
 {
     return document_ids_.begin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const
+std::pmr::set<int>::const_iterator SearchServer::end() const
 {
     return document_ids_.end();
 }
@@ -90,47 +167,30 @@ const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int d
     }
     
     // Verifing document id
-    if (document_id < 0 || !documents_extra_.count(document_id)) 
+    if (document_id < 0 || !documents_.Contains(document_id)) 
     {
         return words_freqs;
     }
 
-    words_freqs = document_to_word_freqs_.at(document_id);
+    ForEachWordOfDocument(document_id, [](std::string_view word, double freq)
+        {
+            words_freqs.emplace(word, freq);
+        });
     return words_freqs;
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view raw_query, int document_id) const {
-    // Получаем список плюс- и минус-слов
+    // Получаем список плюс- и минус-слов, отсортированных для слияния со словами документа
     const Query query = ParseQuery(raw_query);
+    const uint32_t document = documents_.GetNumber(document_id);
+    const MatchQuery match_query = PrepareMatchQuery(query);
 
-    // Хранилище для значимых слов
-    std::vector<std::string_view> matched_words;
-
-    // Пробегаемся по плюс-словам ...
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
-        }
-    }
-
-    // ... и по минус-словам
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-
-        // Если минус-слово, чистим вектор слов и выходим из цикла
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            break;
-        }
-    }
+    // Найденные слова - ссылки на слова словаря
+    std::vector<std::string_view> matched_words(match_query.plus_words.size());
+    matched_words.resize(MatchWords(query, match_query, document_id, matched_words.data()));
 
     // Возвращаем результат
-    return {matched_words, documents_extra_.at(document_id).status};
+    return {matched_words, documents_.GetStatus(document)};
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const
@@ -140,22 +200,208 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const
 {
-    return MatchDocument(raw_query, document_id);
+    const Query query = ParseQuery(policy, raw_query);
+    const uint32_t document = documents_.GetNumber(document_id);
+    const DocumentStatus status = documents_.GetStatus(document);
+    const MatchQuery match_query = PrepareMatchQuery(query);
+
+    // Words of the query are looked for in the document in parallel
+    const auto contains = [this, document_id, document](std::string_view word)
+    {
+        return !FindWordOfDocument(document_id, document, word).empty();
+    };
+    if (std::any_of(policy, match_query.minus_words.begin(), match_query.minus_words.end(), contains)
+        || !std::all_of(policy, match_query.required_words.begin(), match_query.required_words.end(), contains)
+        || !ContainsPhrases(document, query))
+    {
+        return {std::vector<std::string_view>(), status};
+    }
+
+    // Found words are replaced by the words of the dictionary, others by empty words which are removed
+    std::vector<std::string_view> matched_words(match_query.plus_words.size());
+    std::transform(policy, match_query.plus_words.begin(), match_query.plus_words.end(), matched_words.begin(),
+        [this, document_id, document](std::string_view word)
+        {
+            return FindWordOfDocument(document_id, document, word);
+        });
+    matched_words.erase(std::remove(policy, matched_words.begin(), matched_words.end(), std::string_view()), matched_words.end());
+    return {matched_words, status};
+}
+
+MatchResults SearchServer::MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    return MatchDocumentsImpl(std::execution::seq, raw_query, document_ids);
+}
+
+MatchResults SearchServer::MatchDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, 
+    const std::vector<int>& document_ids) const
+{
+    return MatchDocumentsImpl(policy, raw_query, document_ids);
+}
+
+MatchResults SearchServer::MatchDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, 
+    const std::vector<int>& document_ids) const
+{
+    return MatchDocumentsImpl(policy, raw_query, document_ids);
 }
 
 void SearchServer::RemoveDocument(int document_id)
 {
     if (document_ids_.find(document_id) != document_ids_.end())
     {
-        for (auto [document, freqs] : document_to_word_freqs_.at(document_id))
+        const uint32_t number = documents_.GetNumber(document_id);
+
+        // Words of the document are collected before changing the posting lists
+        std::vector<std::pair<std::string_view, double>> word_freqs;
+        ForEachWordOfDocument(document_id, [&word_freqs](std::string_view word, double freq)
+            {
+                word_freqs.push_back({word, freq});
+            });
+
+        if (options_.use_positional_index)
+        {
+            std::vector<std::string_view> words;
+            for (const auto& [word, freq] : word_freqs)
+            {
+                words.push_back(word);
+            }
+            positional_index_.RemoveDocument(number, words);
+        }
+
+        for (auto [word, freq] : word_freqs)
         {
-            word_to_document_freqs_.erase(document);
+            const auto word_it = word_to_postings_.find(word);
+            word_it->second.Remove(number);
+            if (word_it->second.empty())
+            {
+                word_to_postings_.erase(word_it);
+            }
         }
+        DropImpactOrderedPostings(word_freqs);
         document_to_word_freqs_.erase(document_id);
-        documents_extra_.erase(document_id);
+        if (number < document_terms_.size())
+        {
+            document_terms_[number] = std::vector<uint32_t>();
+        }
+        total_word_count_ -= documents_.GetWordCount(number);
+        documents_.Remove(number);
         document_ids_.erase(document_id);
         --document_count_;
+        ++index_version_;
+
+        if (options_.compaction_removed_share > 0.0
+            && documents_.GetRemovedCount() > options_.compaction_removed_share * documents_.GetNumberCount())
+        {
+            Compact();
+        }
+    }
+}
+
+void SearchServer::Compact()
+{
+    if (documents_.GetRemovedCount() == 0)
+    {
+        return;
+    }
+
+    const std::vector<uint32_t> new_numbers = documents_.Compact();
+    for (auto& [word, postings] : word_to_postings_)
+    {
+        postings.Renumber(new_numbers);
+    }
+    positional_index_.Renumber(new_numbers);
+
+    if (!document_terms_.empty())
+    {
+        std::vector<std::vector<uint32_t>> document_terms(documents_.GetNumberCount());
+        for (size_t number = 0; number < document_terms_.size(); ++number)
+        {
+            if (new_numbers[number] != NO_DOCUMENT_NUMBER)
+            {
+                document_terms[new_numbers[number]] = std::move(document_terms_[number]);
+            }
+        }
+        document_terms_ = std::move(document_terms);
+    }
+
+    // Impact-ordered layouts are built again by the next queries
+    std::lock_guard guard(impact_postings_mutex_);
+    impact_postings_.clear();
+}
+
+bool SearchServer::CanScoreByImpact(const Query& query) const
+{
+    if (options_.impact_order_min_postings == 0 || query.plus_words.empty() 
+        || !query.required_words.empty() || !query.phrases.empty() || !query.expanded_words.empty())
+    {
+        return false;
+    }
+    return std::all_of(query.plus_words.begin(), query.plus_words.end(), [this](std::string_view word)
+        {
+            const auto word_it = word_to_postings_.find(word);
+            return word_it != word_to_postings_.end() && word_it->second.size() >= options_.impact_order_min_postings;
+        });
+}
+
+const ImpactOrderedPostings& SearchServer::GetImpactOrderedPostings(std::string_view word) const
+{
+    {
+        std::lock_guard guard(impact_postings_mutex_);
+        const auto it = impact_postings_.find(word);
+        if (it != impact_postings_.end())
+        {
+            return it->second;
+        }
     }
+
+    // Built without the lock, a concurrent query may build the same layout, then one of them is kept
+    // The key is the word of the dictionary: the word of the query lives only as long as the query
+    const auto word_it = word_to_postings_.find(word);
+    ImpactOrderedPostings postings = ImpactOrderedPostings::Build(word_it->second);
+    std::lock_guard guard(impact_postings_mutex_);
+    return impact_postings_.emplace(word_it->first, std::move(postings)).first->second;
+}
+
+MemoryStats SearchServer::GetMemoryStats() const
+{
+    MemoryStats stats;
+    stats.dictionary = term_dictionary_.GetMemoryUsage() + stop_words_.GetMemoryUsage();
+
+    stats.postings = word_to_postings_.GetMemoryUsage();
+    for (const auto& [word, postings] : word_to_postings_)
+    {
+        stats.postings += postings.documents.capacity() * sizeof(uint32_t) + postings.term_freqs.GetMemoryUsage();
+    }
+    {
+        std::lock_guard guard(impact_postings_mutex_);
+        for (const auto& [word, postings] : impact_postings_)
+        {
+            stats.postings += MAP_NODE_OVERHEAD + sizeof(word) + sizeof(postings)
+                + postings.documents.capacity() * sizeof(uint32_t) + postings.term_freqs.capacity() * sizeof(double)
+                + postings.tier_ends.capacity() * sizeof(size_t);
+        }
+    }
+
+    for (const auto& [document_id, word_freqs] : document_to_word_freqs_)
+    {
+        stats.forward_index += MAP_NODE_OVERHEAD + sizeof(document_id) + sizeof(word_freqs)
+            + word_freqs.size() * (MAP_NODE_OVERHEAD + sizeof(std::pair<const std::string_view, double>));
+    }
+    stats.forward_index += document_terms_.capacity() * sizeof(std::vector<uint32_t>);
+    for (const auto& term_ids : document_terms_)
+    {
+        stats.forward_index += term_ids.capacity() * sizeof(uint32_t);
+    }
+
+    stats.content = documents_.GetContentMemoryUsage();
+    stats.metadata = documents_.GetMetadataMemoryUsage() + document_ids_.size() * (MAP_NODE_OVERHEAD + sizeof(int));
+    stats.positional_index = positional_index_.GetMemoryUsage().total_bytes;
+    return stats;
+}
+
+PositionalIndex::MemoryUsage SearchServer::GetPositionalIndexMemoryUsage() const
+{
+    return positional_index_.GetMemoryUsage();
 }
 
 // Parallel version of RemoveDocument(int) with sequenced_policy
@@ -170,12 +416,70 @@ void SearchServer::RemoveDocument(std::execution::parallel_policy policy, int do
     RemoveDocument(document_id);
 }
 
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(std::execution::seq, document_ids);
+}
+
+void SearchServer::RemoveDocuments(std::execution::sequenced_policy policy, const std::vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(policy, document_ids);
+}
+
+void SearchServer::RemoveDocuments(std::execution::parallel_policy policy, const std::vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(policy, document_ids);
+}
+
 
 // ------------------------------- Private ------------------------------- //
 
+namespace
+{
+    // Documents longer than this times the words are searched for every word instead of merging
+    const size_t MATCH_MERGE_SIZE_RATIO = 8;
+
+    // Call callback(word of the document) for every word of sorted_words found in the document
+    // Words of the document are views into the dictionary
+    template <typename Callback>
+    void ForEachCommonWord(const std::vector<std::string_view>& sorted_words, 
+        const std::pmr::map<std::string_view, double>& word_freqs, Callback callback)
+    {
+        if (word_freqs.size() > sorted_words.size() * MATCH_MERGE_SIZE_RATIO)
+        {
+            for (const std::string_view word : sorted_words)
+            {
+                const auto it = word_freqs.find(word);
+                if (it != word_freqs.end())
+                {
+                    callback(it->first);
+                }
+            }
+            return;
+        }
+
+        auto it = word_freqs.begin();
+        for (const std::string_view word : sorted_words)
+        {
+            while (it != word_freqs.end() && it->first < word)
+            {
+                ++it;
+            }
+            if (it == word_freqs.end())
+            {
+                return;
+            }
+            if (it->first == word)
+            {
+                callback(it->first);
+            }
+        }
+    }
+}
+
 bool SearchServer::IsStopWord(const std::string_view word) const 
 {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const
@@ -219,19 +523,487 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         text = text.substr(1);  // for deleting '-' at the begining
     }
+
+    // Required word starts with '+' (+server)
+    bool is_required = false;
+    if (!text.empty() && text[0] == '+')
+    {
+        is_required = true;
+        text = text.substr(1);
+        if (is_minus)
+        {
+            throw std::invalid_argument("Minus-word can't be required!");
+        }
+        if (text.empty() || text[0] == '+' || text[0] == '-')
+        {
+            throw std::invalid_argument("No word after plus!");
+        }
+        if (text.back() == '*' || text.back() == '~' || (text.size() >= 2u && text[text.size() - 2u] == '~'))
+        {
+            throw std::invalid_argument("Only exact words can be required!");
+        }
+    }
+
+    // Prefix ends with '*' (serv*)
+    if (text.back() == '*')
+    {
+        text.remove_suffix(1);
+        if (text.empty())
+        {
+            throw std::invalid_argument("Empty prefix!");
+        }
+        return {text, is_minus, false, false, true, 0};
+    }
+
+    // Fuzzy word ends with '~' and optional max edit distance (sevrer~ or sevrer~2)
+    int fuzzy_distance = 0;
+    if (text.back() == '~')
+    {
+        fuzzy_distance = 1;
+        text.remove_suffix(1);
+    }
+    else if (text.size() >= 2u && text[text.size() - 2u] == '~')
+    {
+        if (text.back() != '1' && text.back() != '2')
+        {
+            throw std::invalid_argument("Edit distance of a fuzzy word must be 1 or 2!");
+        }
+        fuzzy_distance = text.back() - '0';
+        text.remove_suffix(2);
+    }
+    if (fuzzy_distance > 0 && text.empty())
+    {
+        throw std::invalid_argument("Empty fuzzy word!");
+    }
+
     return 
     {
         text,
         is_minus,
-        IsStopWord(text)
+        is_required,
+        fuzzy_distance == 0 && IsStopWord(text),
+        false,
+        fuzzy_distance
     };
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const {
-    return SearchServer::ParseQuery(std::execution::seq, std::string(text));
+    return SearchServer::ParseQuery(std::execution::seq, text);
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const 
+std::vector<PhraseWord> SearchServer::ParsePhrase(std::string_view text) const
 {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+    std::vector<PhraseWord> phrase;
+    uint32_t offset = 0;
+    for (const std::string_view word : SPI(text))
+    {
+        if (word.empty())
+        {
+            continue;
+        }
+        if (word[0] == '-')
+        {
+            throw std::invalid_argument("Minus-words are not allowed inside a phrase!");
+        }
+        if (!IsStopWord(word))
+        {
+            phrase.push_back({word, offset});
+        }
+        ++offset;
+    }
+    return phrase;
+}
+
+std::vector<uint32_t> SearchServer::FindPhraseDocuments(const Query& query) const
+{
+    std::vector<uint32_t> documents;
+    if (query.phrases.empty())
+    {
+        return documents;
+    }
+
+    documents = positional_index_.FindPhraseDocuments(query.phrases[0]);
+    for (size_t i = 1; i < query.phrases.size() && !documents.empty(); ++i)
+    {
+        documents = IntersectPostings(documents, positional_index_.FindPhraseDocuments(query.phrases[i]));
+    }
+    return documents;
+}
+
+SearchServer::Candidates SearchServer::FindCandidates(const Query& query) const
+{
+    Candidates candidates;
+    candidates.is_restricted = !query.phrases.empty() || !query.required_words.empty();
+    if (!candidates.is_restricted)
+    {
+        return candidates;
+    }
+
+    // Posting lists of the required words from the shortest one
+    std::vector<const std::vector<uint32_t>*> postings;
+    for (const std::string_view word : query.required_words)
+    {
+        const auto word_it = word_to_postings_.find(word);
+        if (word_it == word_to_postings_.end())
+        {
+            return candidates;
+        }
+        postings.push_back(&word_it->second.documents);
+    }
+    std::sort(postings.begin(), postings.end(),
+        [](const std::vector<uint32_t>* lhs, const std::vector<uint32_t>* rhs)
+        {
+            return lhs->size() < rhs->size();
+        });
+
+    // Phrases are usually more selective than words, so they go first
+    if (!query.phrases.empty())
+    {
+        candidates.documents = FindPhraseDocuments(query);
+    }
+    else
+    {
+        candidates.documents = *postings[0];
+        postings.erase(postings.begin());
+    }
+    for (size_t i = 0; i < postings.size() && !candidates.documents.empty(); ++i)
+    {
+        candidates.documents = IntersectPostings(candidates.documents, *postings[i]);
+    }
+    return candidates;
+}
+
+size_t SearchServer::GetRangeCount(const Query& query, const Candidates& candidates, size_t thread_count) const
+{
+    if (options_.split_query_postings == 0)
+    {
+        return 1;
+    }
+
+    size_t posting_count = 0;
+    for (const std::string_view word : query.plus_words)
+    {
+        const auto word_it = word_to_postings_.find(word);
+        if (word_it != word_to_postings_.end())
+        {
+            posting_count += candidates.is_restricted 
+                ? std::min(candidates.documents.size(), word_it->second.size()) 
+                : word_it->second.size();
+        }
+    }
+    for (const auto& expanded_words : query.expanded_words)
+    {
+        for (const auto& expanded_word : expanded_words)
+        {
+            posting_count += word_to_postings_.at(expanded_word.word).size();
+        }
+    }
+    return std::clamp<size_t>(posting_count / options_.split_query_postings, 1, thread_count);
+}
+
+SearchServer::MatchQuery SearchServer::PrepareMatchQuery(const Query& query) const
+{
+    MatchQuery match_query;
+    match_query.plus_words.assign(query.plus_words.begin(), query.plus_words.end());
+    for (const auto& expanded_words : query.expanded_words)
+    {
+        for (const auto& [word, weight] : expanded_words)
+        {
+            match_query.plus_words.push_back(word);
+        }
+    }
+    if (!query.expanded_words.empty())
+    {
+        std::sort(match_query.plus_words.begin(), match_query.plus_words.end());
+        match_query.plus_words.erase(std::unique(match_query.plus_words.begin(), match_query.plus_words.end()), 
+            match_query.plus_words.end());
+    }
+    match_query.minus_words.assign(query.minus_words.begin(), query.minus_words.end());
+    match_query.required_words.assign(query.required_words.begin(), query.required_words.end());
+    return match_query;
+}
+
+size_t SearchServer::MatchWords(const Query& query, const MatchQuery& match_query, int document_id, std::string_view* out) const
+{
+    const uint32_t document = documents_.GetNumber(document_id);
+
+    // Sorted words of the query are merged with the full forward index, otherwise they are looked for one by one
+    const auto for_each_found = [this, document_id, document](const std::vector<std::string_view>& words, auto callback)
+    {
+        if (options_.forward_index == ForwardIndexMode::FULL)
+        {
+            ForEachCommonWord(words, document_to_word_freqs_.at(document_id), callback);
+            return;
+        }
+        for (const std::string_view word : words)
+        {
+            const std::string_view found_word = FindWordOfDocument(document_id, document, word);
+            if (!found_word.empty())
+            {
+                callback(found_word);
+            }
+        }
+    };
+
+    bool has_minus_word = false;
+    for_each_found(match_query.minus_words, [&has_minus_word](std::string_view)
+        {
+            has_minus_word = true;
+        });
+    if (has_minus_word)
+    {
+        return 0;
+    }
+
+    size_t required_count = 0;
+    for_each_found(match_query.required_words, [&required_count](std::string_view)
+        {
+            ++required_count;
+        });
+    if (required_count < match_query.required_words.size() || !ContainsPhrases(document, query))
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    for_each_found(match_query.plus_words, [out, &count](std::string_view word)
+        {
+            out[count++] = word;
+        });
+    return count;
+}
+
+std::string_view SearchServer::FindWordOfDocument(int document_id, uint32_t document, std::string_view word) const
+{
+    switch (options_.forward_index)
+    {
+    case ForwardIndexMode::FULL:
+    {
+        const auto& word_freqs = document_to_word_freqs_.at(document_id);
+        const auto it = word_freqs.find(word);
+        return it != word_freqs.end() ? it->first : std::string_view();
+    }
+    case ForwardIndexMode::COMPACT:
+    {
+        const std::optional<uint32_t> id = term_dictionary_.FindId(word);
+        const std::vector<uint32_t>& term_ids = document_terms_[document];
+        return id && std::binary_search(term_ids.begin(), term_ids.end(), *id) ? term_dictionary_.GetWord(*id) : std::string_view();
+    }
+    case ForwardIndexMode::NONE:
+    {
+        const auto word_it = word_to_postings_.find(word);
+        return word_it != word_to_postings_.end() && word_it->second.Contains(document) ? word_it->first : std::string_view();
+    }
+    }
+    return {};
+}
+
+double SearchServer::GetTermFrequency(std::string_view word, uint32_t document) const
+{
+    const PostingList& postings = word_to_postings_.at(word);
+    const auto it = std::lower_bound(postings.documents.begin(), postings.documents.end(), document);
+    return postings.term_freqs[it - postings.documents.begin()];
+}
+
+bool SearchServer::ContainsPhrases(uint32_t document, const Query& query) const
+{
+    return std::all_of(query.phrases.begin(), query.phrases.end(),
+        [this, document](const std::vector<PhraseWord>& phrase)
+        {
+            return positional_index_.ContainsPhrase(document, phrase);
+        });
+}
+
+RoaringBitmap SearchServer::FindExcludedDocuments(const Query& query) const
+{
+    RoaringBitmap excluded_documents;
+    for (const std::string_view word : query.minus_words)
+    {
+        const auto word_it = word_to_postings_.find(word);
+        if (word_it != word_to_postings_.end())
+        {
+            excluded_documents |= RoaringBitmap::FromSorted(word_it->second.documents);
+        }
+    }
+    return excluded_documents;
+}
+
+SearchServer::ExcludedDocuments SearchServer::FindExcludedDocuments(const QueryPlan& plan) const
+{
+    ExcludedDocuments excluded_documents;
+    if (plan.info.minus_strategy == MinusStrategy::MINUS_PROBE)
+    {
+        excluded_documents.probed_postings = plan.minus_postings;
+        return excluded_documents;
+    }
+    for (const PostingList* postings : plan.minus_postings)
+    {
+        excluded_documents.bitmap |= RoaringBitmap::FromSorted(postings->documents);
+    }
+    return excluded_documents;
+}
+
+void SearchServer::ChooseQueryStrategies(const Query& query, QueryPlan& plan) const
+{
+    QueryPlanInfo& info = plan.info;
+    const double document_count = std::max<size_t>(plan.statistics.document_count, 1);
+
+    double plus_postings = 0.0;
+    for (const PlannedWord& word : plan.words)
+    {
+        plus_postings += word.postings->size();
+    }
+    double expanded_postings = 0.0;
+    for (const auto& expanded_words : query.expanded_words)
+    {
+        info.expanded_word_count += expanded_words.size();
+        for (const auto& expanded_word : expanded_words)
+        {
+            expanded_postings += word_to_postings_.at(expanded_word.word).size();
+        }
+    }
+
+    // Postings visited by the scan, every one of them is checked against the minus-words
+    double scanned_postings = 0.0;
+    if (!query.required_words.empty() || !query.phrases.empty())
+    {
+        // Candidates are at most the documents of the shortest required word or phrase word,
+        // lists are galloped through them
+        double candidate_count = document_count;
+        std::vector<std::string_view> restricting_words(query.required_words.begin(), query.required_words.end());
+        for (const auto& phrase : query.phrases)
+        {
+            for (const PhraseWord& phrase_word : phrase)
+            {
+                restricting_words.push_back(phrase_word.word);
+            }
+        }
+        for (const std::string_view word : restricting_words)
+        {
+            const auto word_it = word_to_postings_.find(word);
+            candidate_count = std::min<double>(candidate_count, word_it == word_to_postings_.end() ? 0 : word_it->second.size());
+        }
+
+        info.plus_strategy = PlusStrategy::INTERSECTION;
+        for (const std::string_view word : restricting_words)
+        {
+            const auto word_it = word_to_postings_.find(word);
+            if (word_it != word_to_postings_.end())
+            {
+                info.plus_cost += candidate_count * std::log2(word_it->second.size() + 1.0);
+            }
+        }
+        for (const PlannedWord& word : plan.words)
+        {
+            const double visited = std::min<double>(candidate_count, word.postings->size());
+            scanned_postings += visited;
+            info.plus_cost += visited * std::log2(word.postings->size() + 1.0);
+        }
+        scanned_postings += expanded_postings;
+        info.plus_cost += expanded_postings;
+    }
+    else
+    {
+        // Term at a time updates a map of the found documents for every posting,
+        // document at a time keeps a heap of the current documents of the lists
+        scanned_postings = plus_postings + expanded_postings;
+        const double found_count = std::min(document_count, scanned_postings);
+        const double term_at_a_time_cost = scanned_postings * (1.0 + std::log2(found_count + 1.0));
+        const double document_at_a_time_cost = plus_postings * (1.0 + std::log2(static_cast<double>(plan.words.size())));
+        if (plan.words.size() > 1 && query.expanded_words.empty() && document_at_a_time_cost < term_at_a_time_cost)
+        {
+            info.plus_strategy = PlusStrategy::DOCUMENT_AT_A_TIME;
+            info.plus_cost = document_at_a_time_cost;
+        }
+        else
+        {
+            info.plus_strategy = PlusStrategy::TERM_AT_A_TIME;
+            info.plus_cost = term_at_a_time_cost;
+        }
+    }
+
+    // A bitmap of the minus-words costs their postings, probing costs a binary search per scanned posting and minus-word
+    if (!plan.minus_postings.empty())
+    {
+        double minus_postings = 0.0;
+        double probe_cost = 0.0;
+        for (const PostingList* postings : plan.minus_postings)
+        {
+            minus_postings += postings->size();
+            probe_cost += scanned_postings * std::log2(postings->size() + 1.0);
+        }
+        if (probe_cost < minus_postings)
+        {
+            info.minus_strategy = MinusStrategy::MINUS_PROBE;
+            info.minus_cost = probe_cost;
+        }
+        else
+        {
+            info.minus_strategy = MinusStrategy::MINUS_FIRST;
+            info.minus_cost = minus_postings;
+        }
+    }
+}
+
+std::vector<SearchServer::ExpandedWord> SearchServer::ExpandPrefix(std::string_view prefix, size_t limit) const
+{
+    std::vector<ExpandedWord> expanded_words;
+    if (limit == 0)
+    {
+        return expanded_words;
+    }
+
+    // Dictionary keeps words of removed documents, they are skipped
+    term_dictionary_.ForEachWithPrefix(prefix,
+        [this, &expanded_words, limit](std::string_view word)
+        {
+            if (word_to_postings_.count(word) > 0)
+            {
+                expanded_words.push_back({word, 1.0});
+            }
+            return expanded_words.size() < limit;
+        });
+    return expanded_words;
+}
+
+std::vector<SearchServer::ExpandedWord> SearchServer::ExpandFuzzyWord(std::string_view word, int max_distance, size_t limit) const
+{
+    // Found words by their distance, the closest ones are taken
+    std::vector<std::vector<std::string_view>> words_by_distance(max_distance + 1);
+    const LevenshteinAutomaton automaton(word, max_distance);
+    automaton.ForEachMatch(term_dictionary_,
+        [this, &words_by_distance, limit](std::string_view found_word, int distance)
+        {
+            auto& words = words_by_distance[distance];
+            if (words.size() < limit && word_to_postings_.count(found_word) > 0)
+            {
+                words.push_back(found_word);
+            }
+            return true;
+        });
+
+    std::vector<ExpandedWord> expanded_words;
+    for (int distance = 0; distance <= max_distance; ++distance)
+    {
+        for (const std::string_view found_word : words_by_distance[distance])
+        {
+            if (expanded_words.size() == limit)
+            {
+                return expanded_words;
+            }
+            expanded_words.push_back({found_word, options_.fuzzy_distance_weights[distance]});
+        }
+    }
+    return expanded_words;
+}
+
+CollectionStatistics SearchServer::GetCollectionStatistics() const
+{
+    CollectionStatistics statistics;
+    statistics.document_count = document_count_;
+    if (document_count_ > 0)
+    {
+        statistics.average_document_length = total_word_count_ * 1.0 / document_count_;
+    }
+    return statistics;
 }
@@ -2,11 +2,37 @@
 
 #include "string_processing.h"
 #include "document.h"
+#include "document_filter.h"
+#include "document_store.h"
+#include "impact_ordered_postings.h"
 #include "concurrent_map.h"
+#include "dense_bitset.h"
+#include "levenshtein_automaton.h"
+#include "match_results.h"
+#include "memory_stats.h"
+#include "positional_index.h"
+#include "query_deadline.h"
+#include "posting_intersection.h"
+#include "posting_list.h"
+#include "query_metrics.h"
+#include "query_plan.h"
+#include "roaring_bitmap.h"
+#include "scoring.h"
+#include "search_results.h"
+#include "search_server_options.h"
+#include "stop_word_set.h"
+#include "term_dictionary.h"
+#include "term_hash_map.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <memory>
 #include <map>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
@@ -14,9 +40,14 @@
 #include <stdexcept>
 #include <cctype>
 #include <functional>
+#include <future>
 #include <numeric>
 #include <execution>
 #include <string_view>
+#include <queue>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
 
 // SplitIntoWords analogue (fast fix for building project)
 // TODO: Delete this function and use SplitIntoWords instead
@@ -27,33 +58,49 @@ const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
 class SearchServer 
 {
-    // Structure for storing additional document data: rating and status
-    struct DocumentData
-    {
-        int rating;
-        DocumentStatus status;
-        std::string content;
-    };
-
     // Structure for storing information about a word
     struct QueryWord
     {
         std::string_view data;
         bool is_minus;
+        bool is_required;       // +word: a document must contain the word
         bool is_stop;
+        bool is_prefix;
+        int fuzzy_distance;     // max edit distance of a fuzzy word, 0 for an exact word
+    };
+
+    // Dictionary word found for a query term (prefix or fuzzy word) with its weight in the relevance
+    struct ExpandedWord
+    {
+        std::string_view word;
+        double weight;
     };
 
     // Structure for storing sets of plus- and minus-words for a query
+    // Words of phrases are plus-words too, but a document must contain every phrase
+    // Every plus prefix or fuzzy word is expanded to dictionary words, minus ones are expanded to minus-words
+    // Required words (+word) are plus-words too, but a document must contain every required word
     struct Query
     {
         std::set<std::string_view> plus_words;
         std::set<std::string_view> minus_words;
+        std::set<std::string_view> required_words;
+        std::vector<std::vector<PhraseWord>> phrases;
+        std::vector<std::vector<ExpandedWord>> expanded_words;
     };
 
 public:
     template <typename StringContainer>
-    SearchServer(const StringContainer& stop_words)
+    SearchServer(const StringContainer& stop_words, const SearchServerOptions& options = SearchServerOptions())
+        : options_(options)
+        , term_dictionary_(GetMemoryResource())
+        , word_to_postings_(GetMemoryResource())
+        , document_to_word_freqs_(GetMemoryResource())
+        , documents_(GetMemoryResource())
+        , document_ids_(GetMemoryResource())
+        , positional_index_(GetMemoryResource())
     {
+        std::vector<std::string> words;
         for (const auto& str : stop_words) 
         {
             if (!str.empty())
@@ -62,12 +109,32 @@ public:
                 {
                     throw std::invalid_argument("Error! Line has invalid symbols!");
                 }
-                stop_words_.emplace(std::string(str));
+                words.emplace_back(str);
+            }
+        }
+        stop_words_ = StopWordSet(std::move(words));
+    }
+
+    // Stop words fixed at compile time (see MakeStopWordSet), their perfect hash table is copied, not rebuilt
+    template <size_t N>
+    SearchServer(const StaticStopWordSet<N>& stop_words, const SearchServerOptions& options = SearchServerOptions())
+        : SearchServer(std::vector<std::string>(), options)
+    {
+        for (const std::string_view word : stop_words.GetWords())
+        {
+            if (!IsValidWord(word))
+            {
+                throw std::invalid_argument("Error! Line has invalid symbols!");
             }
         }
+        stop_words_ = StopWordSet(stop_words);
     }
-    SearchServer(const std::string& stop_words_text) : SearchServer(std::string_view(stop_words_text)) {}
-    SearchServer(std::string_view stop_words_text) : SearchServer(SPI(stop_words_text)) {}
+    SearchServer(const std::string& stop_words_text, const SearchServerOptions& options = SearchServerOptions()) 
+        : SearchServer(std::string_view(stop_words_text), options) {}
+    SearchServer(const char* stop_words_text, const SearchServerOptions& options = SearchServerOptions()) 
+        : SearchServer(std::string_view(stop_words_text), options) {}
+    SearchServer(std::string_view stop_words_text, const SearchServerOptions& options = SearchServerOptions()) 
+        : SearchServer(SPI(stop_words_text), options) {}
 
     
     // Add document
@@ -75,64 +142,212 @@ public:
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
     // Find top documents using template and specializations
-    // Params - query
-    // Additional params (specialization) - document status | predicate function
-    template <typename Filter>
+    // Params - query. Query may contain phrases in quotes: "high availability", prefixes: serv*
+    // and fuzzy words with max edit distance 1 or 2: sevrer~ or sevrer~2
+    // Words with plus are required: +cat +dog finds only documents with both words (AND instead of OR)
+    // Additional params (specialization) - document status | DocumentFilter | predicate function
+    // Template param Scorer - scoring policy from scoring.h, TF-IDF by default: FindTopDocuments<Bm25Scorer>(raw_query)
+    template <typename Scorer = TfIdfScorer, typename Filter>
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, Filter filter) const
     {
-        return FindTopDocuments(std::execution::seq, raw_query, filter);
+        return FindTopDocuments<Scorer>(std::execution::seq, raw_query, filter);
+    }
+    template <typename Scorer = TfIdfScorer>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus document_status) const
+    {
+        return FindTopDocuments<Scorer>(std::execution::seq, raw_query, document_status);
     }
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus document_status) const;
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
-    template <class ExecutionPolicy, typename Filter>
+    template <typename Scorer = TfIdfScorer>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const
+    {
+        return FindTopDocuments<Scorer>(std::execution::seq, raw_query);
+    }
+    template <typename Scorer = TfIdfScorer, class ExecutionPolicy, typename Filter>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, Filter filter) const
     {            
+        QueryMetrics* const metrics = GetMetrics();
+        if (metrics)
+        {
+            metrics->AddQuery();
+        }
+
         // Get query with plus- and minus-words
-        const Query query = ParseQuery(policy, std::string(raw_query));
-        
-        // Get all documents by predicate
-        auto matched_documents = FindAllDocuments(policy, query, filter);
+        Query query;
+        {
+            StageTimer timer(metrics, QueryStage::PARSE);
+            query = ParseQuery(policy, raw_query);
+        }
         
-        // First of all sort by relevance, then by rating
-        auto& documents_for_status = documents_extra_;         
-        std::sort(policy,
-            matched_documents.begin(), matched_documents.end(), 
-            [filter, &documents_for_status](const Document& lhs, const Document& rhs) 
+        // Get all documents by predicate, queries of frequent words are scored by impact-ordered postings
+        std::vector<Document> matched_documents;
+        if constexpr (std::is_same_v<Scorer, TfIdfScorer>)
+        {
+            if (CanScoreByImpact(query))
+            {
+                matched_documents = FindTopDocumentsByImpact(query, filter);
+            }
+            else
+            {
+                matched_documents = FindAllDocuments<Scorer>(policy, query, filter, MAX_RESULT_DOCUMENT_COUNT);
+            }
+        }
+        else
+        {
+            matched_documents = FindAllDocuments<Scorer>(policy, query, filter, MAX_RESULT_DOCUMENT_COUNT);
+        }
+        SelectTopDocuments(policy, matched_documents);
+        return matched_documents;
+    }
+    template <typename Scorer = TfIdfScorer, class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const {
+        DocumentFilter filter;
+        filter.status = status;
+        return FindTopDocuments<Scorer>(policy, raw_query, filter);
+    }
+    template <typename Scorer = TfIdfScorer, class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
+        return FindTopDocuments<Scorer>(policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    // Plan of the sequenced FindTopDocuments for the query: statistics of the words, strategies and estimated cost (see query_plan.h)
+    template <typename Scorer = TfIdfScorer>
+    QueryPlanInfo Explain(const std::string_view raw_query) const
+    {
+        const Query query = ParseQuery(std::execution::seq, raw_query);
+        QueryPlanInfo info = BuildQueryPlan<Scorer>(query, MAX_RESULT_DOCUMENT_COUNT).info;
+        if constexpr (std::is_same_v<Scorer, TfIdfScorer>)
+        {
+            if (CanScoreByImpact(query))
+            {
+                info.plus_strategy = PlusStrategy::IMPACT_ORDERED;
+            }
+        }
+        return info;
+    }
+
+    // Find top documents asynchronously on the thread pool of the server (see GetThreadPool)
+    // Scoring checks the deadline and the token between blocks of postings. When the deadline passes or the query is cancelled,
+    // the best of the documents scored so far are returned with the truncated flag
+    // The server must not be changed until the future is ready
+    template <typename Scorer = TfIdfScorer>
+    std::future<TopDocumentsResult> FindTopDocumentsAsync(const std::string_view raw_query, const DocumentFilter& filter,
+        QueryDeadline::Clock::time_point deadline, std::optional<CancellationToken> token = std::nullopt) const
+    {
+        auto promise = std::make_shared<std::promise<TopDocumentsResult>>();
+        std::future<TopDocumentsResult> future = promise->get_future();
+        GetThreadPool().Submit([this, promise, raw_query = std::string(raw_query), filter, deadline, token]()
             {
-                if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) 
+                try
                 {
-                    return lhs.rating > rhs.rating;
-                } 
-                else 
+                    promise->set_value(FindTopDocumentsUntil<Scorer>(raw_query, filter, QueryDeadline(deadline, token)));
+                }
+                catch (...)
                 {
-                    return lhs.relevance > rhs.relevance;
+                    promise->set_exception(std::current_exception());
                 }
             });
+        return future;
+    }
+    template <typename Scorer = TfIdfScorer>
+    std::future<TopDocumentsResult> FindTopDocumentsAsync(const std::string_view raw_query, QueryDeadline::Clock::time_point deadline,
+        std::optional<CancellationToken> token = std::nullopt) const
+    {
+        DocumentFilter filter;
+        filter.status = DocumentStatus::ACTUAL;
+        return FindTopDocumentsAsync<Scorer>(raw_query, filter, deadline, std::move(token));
+    }
+
+    // Find all documents by query without the limit of MAX_RESULT_DOCUMENT_COUNT
+    // Documents are sorted lazily, only when pages of the results are read (see search_results.h)
+    template <typename Scorer = TfIdfScorer, class ExecutionPolicy, typename Filter>
+    SearchResults FindResults(ExecutionPolicy&& policy, const std::string_view raw_query, Filter filter) const
+    {
+        const Query query = ParseQuery(policy, raw_query);
+        return SearchResults(FindAllDocuments<Scorer>(policy, query, filter), index_version_);
+    }
+    template <typename Scorer = TfIdfScorer, typename Filter>
+    SearchResults FindResults(const std::string_view raw_query, Filter filter) const
+    {
+        return FindResults<Scorer>(std::execution::seq, raw_query, filter);
+    }
+    template <typename Scorer = TfIdfScorer>
+    SearchResults FindResults(const std::string_view raw_query) const
+    {
+        return FindResults<Scorer>(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+    }
 
-        // Max document count
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) 
+    // Documents [offset, offset + limit) of the results of the query in the order of relevance
+    // Results of the last query are cached until the next change of the index,
+    // so consecutive pages of the same query are not searched again
+    template <typename Scorer = TfIdfScorer, class ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsPage(ExecutionPolicy&& policy, const std::string_view raw_query, const DocumentFilter& filter,
+        size_t offset, size_t limit) const
+    {
+        {
+            std::lock_guard guard(page_cache_mutex_);
+            if (page_cache_ && page_cache_->results.GetIndexVersion() == index_version_
+                && page_cache_->raw_query == raw_query && page_cache_->filter == filter
+                && page_cache_->scorer == std::type_index(typeid(Scorer)))
+            {
+                if (QueryMetrics* const metrics = GetMetrics())
+                {
+                    metrics->AddPageCacheHit(true);
+                }
+                return page_cache_->results.GetPage(offset, limit);
+            }
+        }
+        if (QueryMetrics* const metrics = GetMetrics())
         {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+            metrics->AddPageCacheHit(false);
         }
 
-        return matched_documents;
+        SearchResults results = FindResults<Scorer>(policy, raw_query, filter);
+        std::vector<Document> page = results.GetPage(offset, limit);
+
+        std::lock_guard guard(page_cache_mutex_);
+        page_cache_.emplace(PageCacheEntry{std::string(raw_query), filter, typeid(Scorer), std::move(results)});
+        return page;
     }
-    template <class ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const {
-        return FindTopDocuments(policy, raw_query, [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
-            return document_status == status;
-            });
+    template <typename Scorer = TfIdfScorer>
+    std::vector<Document> FindTopDocumentsPage(const std::string_view raw_query, DocumentStatus status, size_t offset, size_t limit) const
+    {
+        DocumentFilter filter;
+        filter.status = status;
+        return FindTopDocumentsPage<Scorer>(std::execution::seq, raw_query, filter, offset, limit);
     }
-    template <class ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
-        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    template <typename Scorer = TfIdfScorer>
+    std::vector<Document> FindTopDocumentsPage(const std::string_view raw_query, size_t offset, size_t limit) const
+    {
+        return FindTopDocumentsPage<Scorer>(raw_query, DocumentStatus::ACTUAL, offset, limit);
     }
 
+    // Find top documents (TF-IDF, actual documents) for every query of the batch using the thread pool of the server
+    // Every query is a task of the pool. A heavy query (see SearchServerOptions::split_query_postings)
+    // is split into subtasks by ranges of internal numbers of documents, their results are merged
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& queries) const;
+
+    // Thread pool for batches of queries, created on the first use with SearchServerOptions::query_threads threads
+    ThreadPool& GetThreadPool() const;
+
+    // Durations of stages of queries and counters (if SearchServerOptions::collect_query_metrics is on)
+    QueryMetricsSnapshot GetQueryMetrics() const;
+
+    // Write query metrics in the text format of Prometheus
+    void WriteQueryMetrics(std::ostream& out) const;
+
+    // Give documents dense internal numbers [0, count of documents), reclaiming numbers of removed documents
+    // Posting lists, positions of words and metadata are renumbered keeping the order of documents,
+    // so results of queries don't change. Called by RemoveDocument with SearchServerOptions::compaction_removed_share
+    void Compact();
+
+    // Version of the index, changes on every adding or removing of a document
+    uint64_t GetIndexVersion() const;
+
     int GetDocumentCount() const;
 
     // begin and end for iterating in range-based for
-    std::set<int>::const_iterator begin() const;
-    std::set<int>::const_iterator end() const;
+    std::pmr::set<int>::const_iterator begin() const;
+    std::pmr::set<int>::const_iterator end() const;
 
     // Find word frequrncies in a document by id
     // Return map where key is a word and value is a percentage of the word in the document
@@ -148,6 +363,17 @@ public:
     // Parallel version of RemoveDocument with parallel_policy
     void RemoveDocument(std::execution::parallel_policy policy, int document_id);
 
+    // Removing documents from the server by ids, unknown and repeated ids are skipped
+    // Every posting list containing the documents is filtered once in a linear pass, however many of them it contains,
+    // and the amount of documents (so IDF of words) changes once. Complexity is O(P + N * W) where P is the length of the lists
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Parallel version of RemoveDocuments with sequenced_policy
+    void RemoveDocuments(std::execution::sequenced_policy policy, const std::vector<int>& document_ids);
+
+    // Parallel version of RemoveDocuments with parallel_policy: posting lists are filtered in parallel
+    void RemoveDocuments(std::execution::parallel_policy policy, const std::vector<int>& document_ids);
+
     // Return information about significant words in the document
     // Only take into account plus-words if met
     // at least one negative word - return a vector of words empty together
@@ -160,6 +386,30 @@ public:
     // Parallel version of MatchDocument with parallel_policy
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const;
 
+    // Match the query with a batch of documents, e.g. to highlight words in a page of results
+    // The query is parsed once, words of every document are merged with the sorted words of the query
+    // Matched words are views into the dictionary, all of them are stored in one buffer (see match_results.h)
+    // Throws std::out_of_range if a document is not found
+    MatchResults MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    // Version of MatchDocuments with sequenced_policy
+    MatchResults MatchDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    // Version of MatchDocuments with parallel_policy: documents are matched in parallel
+    MatchResults MatchDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    // Memory used for storing positions of words (empty if positional index is switched off)
+    PositionalIndex::MemoryUsage GetPositionalIndexMemoryUsage() const;
+
+    // Estimated memory of every structure of the server: dictionary, postings, forward index, content, metadata
+    MemoryStats GetMemoryStats() const;
+
+    // Calculate the average rating of a document
+    static int ComputeAverageRating(const std::vector<int>& ratings);
+
+    // Checks for special characters in a string
+    static bool IsValidWord(const std::string_view word);
+
 private: 
     // Checks if a word is a stop-word 
     bool IsStopWord(const std::string_view word) const;
@@ -167,12 +417,6 @@ private:
     // Returns the content of the document without stop words
     std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
     
-    // Calculate the average rating of a document
-    static int ComputeAverageRating(const std::vector<int>& ratings);
-
-    // Checks for special characters in a string
-    static bool IsValidWord(const std::string_view word);
-
     
     // Distribute a word in a query into sets of plus- or minus-words
     QueryWord ParseQueryWord(std::string_view text) const;
@@ -180,16 +424,17 @@ private:
     // Parse the line into a query
     Query ParseQuery(const std::string_view text) const;
 
+    // Parse words of a phrase (text between quotes), stop-words keep their places in the phrase
+    std::vector<PhraseWord> ParsePhrase(std::string_view text) const;
+
     template<class ExecutionPolicy>
-    Query ParseQuery(ExecutionPolicy&& policy, const std::string query_text) const 
+    Query ParseQuery([[maybe_unused]] ExecutionPolicy&& policy, std::string_view text) const 
     {
         // Check query:
         // 1. Special symbols
         // 2. More than one minus before minus-words (if minus at the midle it is ok)
         // 3. After minus there is no text
 
-        std::string_view text(query_text);
-
         // 1. Special symbols
         if (!IsValidWord(text))
         {
@@ -232,179 +477,1351 @@ private:
         }
 
         Query query;
-        for (const std::string_view word : SPI(text))
+        const auto add_words = [this, &query](std::string_view words_text)
+        {
+            for (const std::string_view word : SPI(words_text))
+            {
+                if (word.empty())
+                {
+                    continue;
+                }
+                const QueryWord query_word = ParseQueryWord(word);
+                if (query_word.is_prefix || query_word.fuzzy_distance > 0)
+                {
+                    // Expansions limit only the scored words: a minus-term excludes documents with any of its words
+                    const size_t limit = query_word.is_minus ? std::numeric_limits<size_t>::max()
+                        : query_word.is_prefix ? options_.max_prefix_expansions : options_.max_fuzzy_expansions;
+                    std::vector<ExpandedWord> expanded_words = query_word.is_prefix 
+                        ? ExpandPrefix(query_word.data, limit) 
+                        : ExpandFuzzyWord(query_word.data, query_word.fuzzy_distance, limit);
+                    if (query_word.is_minus)
+                    {
+                        for (const auto& expanded_word : expanded_words)
+                        {
+                            query.minus_words.insert(expanded_word.word);
+                        }
+                    }
+                    else if (!expanded_words.empty())
+                    {
+                        query.expanded_words.push_back(std::move(expanded_words));
+                    }
+                }
+                else if (!query_word.is_stop)
+                {
+                    if (query_word.is_minus)
+                    {
+                        query.minus_words.insert(query_word.data);
+                    }
+                    else
+                    {
+                        query.plus_words.insert(query_word.data);
+                        if (query_word.is_required)
+                        {
+                            query.required_words.insert(query_word.data);
+                        }
+                    }
+                }
+            }
+        };
+
+        // Phrases are in quotes, other words are parsed as usual
+        for (size_t quote = text.find('"'); quote != text.npos; quote = text.find('"'))
         {
-            const QueryWord query_word = ParseQueryWord(word);
-            if (!query_word.is_stop)
+            const size_t closing_quote = text.find('"', quote + 1u);
+            if (closing_quote == text.npos)
+            {
+                throw std::invalid_argument("No closing quote for a phrase!");
+            }
+            if (quote > 0u && text[quote - 1u] == '-')
             {
-                if (query_word.is_minus)
+                throw std::invalid_argument("Minus-phrases are not supported!");
+            }
+            add_words(text.substr(0u, quote));
+
+            std::vector<PhraseWord> phrase = ParsePhrase(text.substr(quote + 1u, closing_quote - quote - 1u));
+            if (!phrase.empty())
+            {
+                if (!options_.use_positional_index)
                 {
-                    query.minus_words.insert(query_word.data);
+                    throw std::invalid_argument("Phrase queries require positional index!");
                 }
-                else
+                for (const PhraseWord& phrase_word : phrase)
                 {
-                    query.plus_words.insert(query_word.data);
+                    query.plus_words.insert(phrase_word.word);
                 }
+                query.phrases.push_back(std::move(phrase));
             }
+            text.remove_prefix(closing_quote + 1u);
         }
+        add_words(text);
+
         return query;
     }
     
-    // Calculate IDF of word
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    // Find dictionary words starting with prefix, at most limit of them
+    std::vector<ExpandedWord> ExpandPrefix(std::string_view prefix, size_t limit) const;
 
-    // Find all documents in SearchServer by query. Filter for filtering documents (predicate) 
-    // Note* : cannot use first template with ExecutionPolicy because of avoiding temp copy between two function calls
-    template <typename Filter>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, Filter filter) const
+    // Find dictionary words within the edit distance from word, at most limit of the closest ones
+    std::vector<ExpandedWord> ExpandFuzzyWord(std::string_view word, int max_distance, size_t limit) const;
+
+    // Find documents containing all phrases of the query
+    // Return sorted internal numbers of documents
+    std::vector<uint32_t> FindPhraseDocuments(const Query& query) const;
+
+    // Check if the document contains all phrases of the query
+    bool ContainsPhrases(uint32_t document, const Query& query) const;
+
+    // Words of the query for matching with documents, every vector is sorted and has no duplicates
+    // Plus-words include words expanded from prefixes and fuzzy words
+    struct MatchQuery
     {
-        // Relevance
-        std::map<int, double> document_to_relevance;
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+        std::vector<std::string_view> required_words;
+    };
+
+    MatchQuery PrepareMatchQuery(const Query& query) const;
 
-        // Calculate relevance using TF-IDF
-        for (auto word : query.plus_words)
+    // Find the word in the document using the forward index (or the posting list if there is no forward index)
+    // Return the word of the dictionary or an empty view if the document doesn't contain the word
+    std::string_view FindWordOfDocument(int document_id, uint32_t document, std::string_view word) const;
+
+    // Term frequency of the word in the document containing it, taken from the posting list
+    double GetTermFrequency(std::string_view word, uint32_t document) const;
+
+    // Call callback(word of the dictionary, term frequency) for every word of the document
+    // Without the forward index all posting lists are scanned
+    template <typename Callback>
+    void ForEachWordOfDocument(int document_id, Callback callback) const
+    {
+        const uint32_t document = documents_.GetNumber(document_id);
+        switch (options_.forward_index)
         {
-            if (word_to_document_freqs_.count(word) == 0)
+        case ForwardIndexMode::FULL:
+            for (const auto& [word, freq] : document_to_word_freqs_.at(document_id))
             {
-                continue;
+                callback(word, freq);
             }
-
-            // Find IDF of word ...
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-
-            // Filter documents by plus words (by word we find a document dictionary, where the key is the document ID 
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+            break;
+        case ForwardIndexMode::COMPACT:
+            for (const uint32_t id : document_terms_[document])
             {
-                // For quick access to additional document information
-                const auto& document_extra_data = documents_extra_.at(document_id);
-
-                // If the document passes through the filter, calculate TF-IDF 
-                if (filter(document_id, document_extra_data.status, document_extra_data.rating))
+                const std::string_view word = term_dictionary_.GetWord(id);
+                callback(word, GetTermFrequency(word, document));
+            }
+            break;
+        case ForwardIndexMode::NONE:
+            for (const auto& [word, postings] : word_to_postings_)
+            {
+                const auto it = std::lower_bound(postings.documents.begin(), postings.documents.end(), document);
+                if (it != postings.documents.end() && *it == document)
                 {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                    callback(word, postings.term_freqs[it - postings.documents.begin()]);
                 }
             }
+            break;
         }
+    }
+
+    // Resource for the containers of the index (SearchServerOptions::memory_resource or the global allocator)
+    std::pmr::memory_resource* GetMemoryResource() const
+    {
+        return options_.memory_resource ? options_.memory_resource : std::pmr::get_default_resource();
+    }
+
+    // Write matched words of the document to out (at most match_query.plus_words.size() words)
+    // Return amount of the words, 0 if the document has a minus-word or lacks a required word or a phrase
+    size_t MatchWords(const Query& query, const MatchQuery& match_query, int document_id, std::string_view* out) const;
 
-        // Remove documents with negative keywords from the result
-        for (auto word : query.minus_words)
+    // Match the query with the documents in the order of the policy
+    template <class ExecutionPolicy>
+    MatchResults MatchDocumentsImpl(ExecutionPolicy&& policy, const std::string_view raw_query, const std::vector<int>& document_ids) const
+    {
+        // Documents are checked before the parallel part: exceptions can't leave a parallel algorithm
+        for (const int document_id : document_ids)
         {
-            if (word_to_document_freqs_.count(word) == 0)
+            if (!documents_.Contains(document_id))
             {
-                continue;
-            }
-            for (const auto document_to_erase : word_to_document_freqs_.at(word))
-            {
-                document_to_relevance.erase(document_to_erase.first);
+                throw std::out_of_range("Document is not found!");
             }
         }
 
-        // Prepare the result for returning information about all documents upon query, we also filter it
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance)
-        {
-            matched_documents.push_back(
-                {
-                    document_id,
-                    relevance,
-                    documents_extra_.at(document_id).rating
-                });
-        }
+        const Query query = ParseQuery(policy, raw_query);
+        const MatchQuery match_query = PrepareMatchQuery(query);
+        const size_t max_word_count = match_query.plus_words.size();
 
-        // Return result documents
-        return matched_documents;
+        // Every document writes its words to its own slot of max_word_count words of the buffer
+        MatchResults results;
+        results.document_ids = document_ids;
+        results.statuses.resize(document_ids.size());
+        results.word_ends.resize(document_ids.size());
+        results.words.resize(document_ids.size() * max_word_count);
+        // Parallel algorithms may pass copies of elements, so slots are found by indexes, not by addresses of ids
+        std::vector<size_t> indexes(document_ids.size());
+        std::iota(indexes.begin(), indexes.end(), size_t{0});
+        std::for_each(policy, indexes.begin(), indexes.end(), 
+            [&](size_t index)
+            {
+                const int document_id = document_ids[index];
+                results.statuses[index] = documents_.GetStatus(documents_.GetNumber(document_id));
+                results.word_ends[index] = MatchWords(query, match_query, document_id, results.words.data() + index * max_word_count);
+            });
 
+        // Slots are packed in place: a slot never moves forward
+        size_t end = 0;
+        for (size_t index = 0; index < document_ids.size(); ++index)
+        {
+            const auto slot = results.words.begin() + index * max_word_count;
+            end = std::copy(slot, slot + results.word_ends[index], results.words.begin() + end) - results.words.begin();
+            results.word_ends[index] = end;
+        }
+        results.words.resize(end);
+        return results;
     }
-    template <typename Filter>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, Filter filter) const
-    {
-        // Relevance
-        ConcurrentMap<int, double> document_to_relevance;
 
-        // Calculate relevance using TF-IDF
-        std::for_each(
-            std::execution::par,
-            query.plus_words.begin(), query.plus_words.end(),
-            [&](const auto word)
+    // Remove the documents filtering the posting lists in the order of the policy
+    template <class ExecutionPolicy>
+    void RemoveDocumentsImpl(ExecutionPolicy&& policy, const std::vector<int>& document_ids)
+    {
+        // Internal numbers of the documents to remove
+        DenseBitset removed;
+        std::vector<std::pair<uint32_t, int>> documents;
+        for (const int document_id : document_ids)
+        {
+            if (document_ids_.count(document_id) > 0)
             {
-                if (word_to_document_freqs_.count(word) == 0)
+                const uint32_t number = documents_.GetNumber(document_id);
+                if (!removed.Test(number))
                 {
-                    return;
+                    removed.Set(number);
+                    documents.push_back({number, document_id});
                 }
+            }
+        }
+        if (documents.empty())
+        {
+            return;
+        }
 
-                // Find IDF of word ...
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-
-                // Filter documents by plus words (by word we find a document dictionary, where the key is the document ID 
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+        // Posting lists containing the documents, grouped by list; without the forward index every list may contain them
+        struct AffectedPostings
+        {
+            PostingList* postings;
+            std::string_view word;
+            std::vector<uint32_t> removed_documents;
+        };
+        std::vector<AffectedPostings> affected;
+        const auto add_word = [this, &affected](std::string_view word)
+        {
+            const auto word_it = word_to_postings_.find(word);
+            affected.push_back({&word_it->second, word_it->first, {}});
+        };
+        switch (options_.forward_index)
+        {
+        case ForwardIndexMode::FULL:
+            for (const auto& [number, document_id] : documents)
+            {
+                for (const auto& [word, freq] : document_to_word_freqs_.at(document_id))
                 {
-                    // For quick access to additional document information
-                    const auto& document_extra_data = documents_extra_.at(document_id);
-
-                    // If the document passes through the filter, calculate TF-IDF 
-                    if (filter(document_id, document_extra_data.status, document_extra_data.rating))
-                    {
-                        document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                    }
+                    add_word(word);
                 }
             }
-        );
-
+            break;
+        case ForwardIndexMode::COMPACT:
+        {
+            std::vector<uint32_t> term_ids;
+            for (const auto& [number, document_id] : documents)
+            {
+                term_ids.insert(term_ids.end(), document_terms_[number].begin(), document_terms_[number].end());
+            }
+            std::sort(term_ids.begin(), term_ids.end());
+            term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+            for (const uint32_t id : term_ids)
+            {
+                add_word(term_dictionary_.GetWord(id));
+            }
+            break;
+        }
+        case ForwardIndexMode::NONE:
+            for (auto& [word, postings] : word_to_postings_)
+            {
+                affected.push_back({&postings, word, {}});
+            }
+            break;
+        }
+        // Lists never move, so they are grouped by address, not by comparing words
+        std::sort(affected.begin(), affected.end(), [](const AffectedPostings& lhs, const AffectedPostings& rhs)
+            {
+                return lhs.postings < rhs.postings;
+            });
+        affected.erase(std::unique(affected.begin(), affected.end(), [](const AffectedPostings& lhs, const AffectedPostings& rhs)
+            {
+                return lhs.postings == rhs.postings;
+            }), affected.end());
 
-        // Remove documents with negative keywords from the result
-        std::for_each(
-            std::execution::par,
-            query.minus_words.begin(), query.minus_words.end(),
-            [&](const auto word)
+        // The table doesn't change until all lists are filtered, so they are filtered in parallel
+        std::for_each(policy, affected.begin(), affected.end(), [&removed](AffectedPostings& entry)
             {
-                if (word_to_document_freqs_.count(word) == 0)
+                for (const uint32_t number : entry.postings->documents)
                 {
-                    return;
+                    if (removed.Test(number))
+                    {
+                        entry.removed_documents.push_back(number);
+                    }
                 }
-                for (const auto [document_id, freq] : word_to_document_freqs_.at(word))
+                if (!entry.removed_documents.empty())
                 {
-                    document_to_relevance.Erase(document_id);
+                    entry.postings->RemoveIf([&removed](uint32_t number)
+                        {
+                            return removed.Test(number);
+                        });
                 }
-            }
-        );
+            });
 
+        // Nodes of the maps come from the memory resource of the index, so the rest is done sequentially
+        std::vector<std::pair<std::string_view, size_t>> changed_words;
+        for (const AffectedPostings& entry : affected)
+        {
+            if (entry.removed_documents.empty())
+            {
+                continue;
+            }
+            changed_words.push_back({entry.word, entry.removed_documents.size()});
+            if (options_.use_positional_index)
+            {
+                positional_index_.RemoveDocuments(entry.word, entry.removed_documents);
+            }
+            if (entry.postings->empty())
+            {
+                word_to_postings_.erase(word_to_postings_.find(entry.word));
+            }
+        }
+        DropImpactOrderedPostings(changed_words);
 
-        // Prepare the result for returning information about all documents upon query, we also filter it
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap())
+        for (const auto& [number, document_id] : documents)
         {
-            matched_documents.push_back(
-                {
-                    document_id,
-                    relevance,
-                    documents_extra_.at(document_id).rating
-                });
+            document_to_word_freqs_.erase(document_id);
+            if (number < document_terms_.size())
+            {
+                document_terms_[number] = std::vector<uint32_t>();
+            }
+            total_word_count_ -= documents_.GetWordCount(number);
+            documents_.Remove(number);
+            document_ids_.erase(document_id);
         }
+        document_count_ -= documents.size();
+        ++index_version_;
 
-        // Return result documents
-        return matched_documents;
+        if (options_.compaction_removed_share > 0.0
+            && documents_.GetRemovedCount() > options_.compaction_removed_share * documents_.GetNumberCount())
+        {
+            Compact();
+        }
     }
 
+    // Statistics of the collection for scorers
+    CollectionStatistics GetCollectionStatistics() const;
 
-private:
+    // Metrics to record into or nullptr if collection is switched off
+    QueryMetrics* GetMetrics() const
+    {
+        return options_.collect_query_metrics ? &metrics_ : nullptr;
+    }
 
-    // Set of stop words
-    std::set<std::string, std::less<>> stop_words_;
+    // Union of posting lists of the minus-words
+    RoaringBitmap FindExcludedDocuments(const Query& query) const;
 
-    // Data structure that stores information about each word:
-    // ID of documents where this word occurs, share in these documents 
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
+    // Plus-word to scan with its posting list and weight
+    struct PlannedWord
+    {
+        std::string_view word;
+        const PostingList* postings;
+        double weight;
+    };
 
-    // Data structure that stores information about each document:
-    // Key - id of a document, value - map of words frequencies
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    // Evaluation of a query chosen by the planner (see query_plan.h)
+    struct QueryPlan
+    {
+        CollectionStatistics statistics;
+        std::vector<PlannedWord> words;                     // plus-words of non-zero weight in the order of the query
+        const PostingList* zero_weight_postings = nullptr;  // the shortest posting list of the plus-words of zero weight
+        std::vector<const PostingList*> minus_postings;
+        size_t result_limit = std::numeric_limits<size_t>::max();   // documents of the result needed by the caller
+        QueryPlanInfo info;
+    };
 
-    // Data structure for storing additional information about documents 
-    std::map<int, DocumentData> documents_extra_;
+    // Resolve words of the query once and choose strategies by their document frequencies
+    // result_limit - amount of the most relevant documents the caller needs
+    template <typename Scorer>
+    QueryPlan BuildQueryPlan(const Query& query, size_t result_limit) const
+    {
+        QueryPlan plan;
+        plan.statistics = GetCollectionStatistics();
+        plan.result_limit = result_limit;
 
-    // Amount of documents
-    size_t document_count_ = 0;
+        for (const std::string_view word : query.plus_words)
+        {
+            PlannedTerm& term = plan.info.plus_terms.emplace_back();
+            term.word = std::string(word);
+            const auto word_it = word_to_postings_.find(word);
+            if (word_it == word_to_postings_.end())
+            {
+                term.is_dropped = true;
+                continue;
+            }
+            const PostingList& postings = word_it->second;
+            term.document_freq = postings.size();
+            term.weight = Scorer::ComputeWeight(plan.statistics, postings.size());
+            if (term.weight == 0.0)
+            {
+                term.is_dropped = true;
+                if (!plan.zero_weight_postings || postings.size() < plan.zero_weight_postings->size())
+                {
+                    plan.zero_weight_postings = &postings;
+                }
+                continue;
+            }
+            plan.words.push_back({word_it->first, &postings, term.weight});
+        }
+
+        for (const std::string_view word : query.minus_words)
+        {
+            PlannedTerm& term = plan.info.minus_terms.emplace_back();
+            term.word = std::string(word);
+            const auto word_it = word_to_postings_.find(word);
+            term.is_dropped = word_it == word_to_postings_.end();
+            if (!term.is_dropped)
+            {
+                term.document_freq = word_it->second.size();
+                plan.minus_postings.push_back(&word_it->second);
+            }
+        }
+
+        ChooseQueryStrategies(query, plan);
+        return plan;
+    }
+
+    // Estimate costs of the strategies for the resolved words of the plan and choose the cheapest ones
+    void ChooseQueryStrategies(const Query& query, QueryPlan& plan) const;
+
+    // Documents of minus-words: a bitmap built before scanning (MINUS_FIRST) or posting lists searched for every document (MINUS_PROBE)
+    struct ExcludedDocuments
+    {
+        RoaringBitmap bitmap;
+        std::vector<const PostingList*> probed_postings;
+
+        bool Contains(uint32_t document) const
+        {
+            return bitmap.Contains(document) || std::any_of(probed_postings.begin(), probed_postings.end(),
+                [document](const PostingList* postings)
+                {
+                    return postings->Contains(document);
+                });
+        }
+    };
+
+    ExcludedDocuments FindExcludedDocuments(const QueryPlan& plan) const;
+
+    // Documents which can match the query: documents with all phrases and all required words
+    // If the query has neither, any document can match (is_restricted is false)
+    struct Candidates
+    {
+        bool is_restricted = false;
+        std::vector<uint32_t> documents;
+    };
+
+    // Intersect posting lists of the required words from the shortest one and documents with the phrases
+    Candidates FindCandidates(const Query& query) const;
+
+    // Range [first, last) of internal numbers of documents to score, all documents by default
+    struct DocumentRange
+    {
+        uint32_t first = 0;
+        uint32_t last = std::numeric_limits<uint32_t>::max();
+    };
+
+    // Amount of subtasks for the query in a pool of thread_count threads:
+    // one per SearchServerOptions::split_query_postings postings to scan
+    size_t GetRangeCount(const Query& query, const Candidates& candidates, size_t thread_count) const;
+
+    static bool IsCandidate(const Candidates& candidates, uint32_t document)
+    {
+        return !candidates.is_restricted 
+            || std::binary_search(candidates.documents.begin(), candidates.documents.end(), document);
+    }
+
+    // Check if the document passes through the filter
+    // DocumentFilter is pushed down to the bitmap of the status and the column of ratings,
+    // other predicates get values from the columns of the document store
+    template <typename Filter>
+    bool PassesFilter(uint32_t document, Filter& filter) const
+    {
+        if constexpr (std::is_same_v<std::decay_t<Filter>, DocumentStatus>)
+        {
+            return documents_.HasStatus(document, filter);
+        }
+        else if constexpr (std::is_same_v<std::decay_t<Filter>, DocumentFilter>)
+        {
+            if (filter.status && !documents_.HasStatus(document, *filter.status))
+            {
+                return false;
+            }
+            const int rating = documents_.GetRating(document);
+            return filter.min_rating <= rating && rating <= filter.max_rating;
+        }
+        else
+        {
+            return filter(documents_.GetId(document), documents_.GetStatus(document), documents_.GetRating(document));
+        }
+    }
+
+    // Calculate relevance of documents containing the plus-word
+    // add_relevance(document, relevance) is called for every candidate passed through minus-words and the filter
+    // If candidates are restricted, only they are looked for in the posting list, other documents are not visited
+    // Otherwise only postings of documents of the range are visited, the deadline is checked between blocks of them
+    template <typename Scorer, typename Filter, typename AddRelevance>
+    void ScoreWord(const PlannedWord& word, const Candidates& candidates, const ExcludedDocuments& excluded_documents,
+        const CollectionStatistics& statistics, Filter& filter, const DocumentRange& range, const QueryDeadline& deadline,
+        AddRelevance add_relevance) const
+    {
+        const PostingList& postings = *word.postings;
+        const double weight = word.weight;
+
+        // Filter documents by plus words: the filter is checked before scoring
+        const auto score = [&](size_t i, double term_freq)
+        {
+            const uint32_t document = postings.documents[i];
+            if (excluded_documents.Contains(document) || !PassesFilter(document, filter))
+            {
+                return;
+            }
+
+            int document_length = 0;
+            if constexpr (Scorer::USES_DOCUMENT_LENGTH)
+            {
+                document_length = documents_.GetWordCount(document);
+            }
+            add_relevance(document, Scorer::Score(weight, term_freq, document_length, statistics));
+        };
+
+        // Postings of documents of the range
+        const size_t first = range.first == 0 ? 0
+            : std::lower_bound(postings.documents.begin(), postings.documents.end(), range.first) - postings.documents.begin();
+        const size_t last = range.last == std::numeric_limits<uint32_t>::max() ? postings.size()
+            : std::lower_bound(postings.documents.begin() + first, postings.documents.end(), range.last) - postings.documents.begin();
+
+        if (QueryMetrics* const metrics = GetMetrics())
+        {
+            metrics->AddPostingsScanned(candidates.is_restricted 
+                ? std::min(candidates.documents.size(), postings.size()) 
+                : last - first);
+        }
+
+        if (candidates.is_restricted)
+        {
+            postings.term_freqs.Visit([&](auto read_term_freq)
+                {
+                    ForEachCommon(candidates.documents, postings.documents,
+                        [&score, &read_term_freq]([[maybe_unused]] size_t candidate_index, size_t posting_index)
+                        {
+                            score(posting_index, read_term_freq(posting_index));
+                        });
+                });
+        }
+        else
+        {
+            // Term frequencies of a block are decoded at once, with a vectorized loop over the stored type
+            std::vector<double> term_freqs(std::min(last - first, size_t{QueryDeadline::CHECK_INTERVAL}));
+            for (size_t block = first; block < last; block += QueryDeadline::CHECK_INTERVAL)
+            {
+                if (block != first && deadline.IsExpired())
+                {
+                    return;
+                }
+                const size_t block_end = std::min(last, block + QueryDeadline::CHECK_INTERVAL);
+                postings.term_freqs.Decode(block, block_end, term_freqs.data());
+                for (size_t i = block; i < block_end; ++i)
+                {
+                    score(i, term_freqs[i - block]);
+                }
+            }
+        }
+    }
+
+    // Calculate relevance of documents containing words expanded from one query term (prefix or fuzzy word)
+    // Posting lists of the words are merged using a heap by document number,
+    // so add_relevance is called once for every document with the sum of weighted relevance of the words in it
+    // Only documents of the range are visited, the deadline is checked between blocks of postings
+    template <typename Scorer, typename Filter, typename AddRelevance>
+    void ScoreExpandedWords(const std::vector<ExpandedWord>& expanded_words, const Candidates& candidates,
+        const ExcludedDocuments& excluded_documents, const CollectionStatistics& statistics, Filter& filter, 
+        const DocumentRange& range, const QueryDeadline& deadline, AddRelevance add_relevance) const
+    {
+        struct Cursor
+        {
+            const PostingList* postings;
+            size_t index;
+            double weight;
+            TermFreqBlockReader term_freqs;
+        };
+
+        std::vector<Cursor> cursors;
+        cursors.reserve(expanded_words.size());
+        for (const auto& [word, weight] : expanded_words)
+        {
+            const PostingList& postings = word_to_postings_.at(word);
+            const size_t first = std::lower_bound(postings.documents.begin(), postings.documents.end(), range.first) 
+                - postings.documents.begin();
+            cursors.push_back({&postings, first, weight * Scorer::ComputeWeight(statistics, postings.size()),
+                TermFreqBlockReader(postings.term_freqs, postings.size())});
+            if (QueryMetrics* const metrics = GetMetrics())
+            {
+                metrics->AddPostingsScanned(postings.size());
+            }
+        }
+
+        // Min-heap of current document of every posting list and index of the list
+        using HeapItem = std::pair<uint32_t, size_t>;
+        std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+        for (size_t i = 0; i < cursors.size(); ++i)
+        {
+            if (cursors[i].index < cursors[i].postings->size())
+            {
+                heap.push({cursors[i].postings->documents[cursors[i].index], i});
+            }
+        }
+
+        size_t visited_postings = 0;
+        size_t next_check = QueryDeadline::CHECK_INTERVAL;
+        while (!heap.empty() && heap.top().first < range.last)
+        {
+            if (visited_postings >= next_check)
+            {
+                if (deadline.IsExpired())
+                {
+                    return;
+                }
+                next_check += QueryDeadline::CHECK_INTERVAL;
+            }
+
+            const uint32_t document = heap.top().first;
+            const bool passes = !excluded_documents.Contains(document)
+                && IsCandidate(candidates, document) && PassesFilter(document, filter);
+            int document_length = 0;
+            if constexpr (Scorer::USES_DOCUMENT_LENGTH)
+            {
+                document_length = documents_.GetWordCount(document);
+            }
+
+            double relevance = 0.0;
+            while (!heap.empty() && heap.top().first == document)
+            {
+                const size_t index = heap.top().second;
+                heap.pop();
+                ++visited_postings;
+                Cursor& cursor = cursors[index];
+                if (passes)
+                {
+                    relevance += Scorer::Score(cursor.weight, cursor.term_freqs[cursor.index], document_length, statistics);
+                }
+                if (++cursor.index < cursor.postings->size())
+                {
+                    heap.push({cursor.postings->documents[cursor.index], index});
+                }
+            }
+
+            if (passes)
+            {
+                add_relevance(document, relevance);
+            }
+        }
+    }
+
+    // Calculate relevance of documents of the range by merging posting lists of the plan by document (DOCUMENT_AT_A_TIME)
+    // Posting lists are merged using a heap by document number, relevance of a document is summed in the order of the words
+    // as by ScoreWord, so it is the same. Documents of the result are in the order of internal numbers
+    template <typename Scorer, typename Filter>
+    std::vector<std::pair<uint32_t, double>> ScoreWordsByDocument(const QueryPlan& plan, const ExcludedDocuments& excluded_documents,
+        Filter& filter, const DocumentRange& range, const QueryDeadline& deadline) const
+    {
+        struct Cursor
+        {
+            size_t index;
+            size_t last;
+            TermFreqBlockReader term_freqs;
+        };
+
+        std::vector<Cursor> cursors;
+        cursors.reserve(plan.words.size());
+        size_t posting_count = 0;
+        for (const PlannedWord& word : plan.words)
+        {
+            const std::vector<uint32_t>& documents = word.postings->documents;
+            const size_t first = std::lower_bound(documents.begin(), documents.end(), range.first) - documents.begin();
+            const size_t last = std::lower_bound(documents.begin() + first, documents.end(), range.last) - documents.begin();
+            cursors.push_back({first, last, TermFreqBlockReader(word.postings->term_freqs, last)});
+            posting_count += last - first;
+        }
+        if (QueryMetrics* const metrics = GetMetrics())
+        {
+            metrics->AddPostingsScanned(posting_count);
+        }
+
+        // Min-heap of current document of every posting list and index of the list
+        using HeapItem = std::pair<uint32_t, size_t>;
+        std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+        for (size_t i = 0; i < cursors.size(); ++i)
+        {
+            if (cursors[i].index < cursors[i].last)
+            {
+                heap.push({plan.words[i].postings->documents[cursors[i].index], i});
+            }
+        }
+
+        std::vector<std::pair<uint32_t, double>> document_relevances;
+        size_t visited_postings = 0;
+        size_t next_check = QueryDeadline::CHECK_INTERVAL;
+        while (!heap.empty())
+        {
+            if (visited_postings >= next_check)
+            {
+                if (deadline.IsExpired())
+                {
+                    break;
+                }
+                next_check += QueryDeadline::CHECK_INTERVAL;
+            }
+
+            const uint32_t document = heap.top().first;
+            const bool passes = !excluded_documents.Contains(document) && PassesFilter(document, filter);
+            int document_length = 0;
+            if constexpr (Scorer::USES_DOCUMENT_LENGTH)
+            {
+                document_length = documents_.GetWordCount(document);
+            }
+
+            double relevance = 0.0;
+            while (!heap.empty() && heap.top().first == document)
+            {
+                const size_t index = heap.top().second;
+                heap.pop();
+                ++visited_postings;
+                const PlannedWord& word = plan.words[index];
+                Cursor& cursor = cursors[index];
+                if (passes)
+                {
+                    relevance += Scorer::Score(word.weight, cursor.term_freqs[cursor.index], document_length, plan.statistics);
+                }
+                if (++cursor.index < cursor.last)
+                {
+                    heap.push({word.postings->documents[cursor.index], index});
+                }
+            }
+
+            if (passes)
+            {
+                document_relevances.push_back({document, relevance});
+            }
+        }
+        return document_relevances;
+    }
+
+    // Add documents of the range containing plus-words of zero weight with zero relevance (see query_plan.h)
+    // They are skipped if the documents found have enough documents with positive relevance for the result of the caller:
+    // a document of zero relevance can't get ahead of them
+    // Found documents are in the order of internal numbers and stay in it
+    template <typename Filter>
+    void AddZeroWeightDocuments(const QueryPlan& plan, const Candidates& candidates, const ExcludedDocuments& excluded_documents,
+        Filter& filter, const DocumentRange& range, std::vector<std::pair<uint32_t, double>>& document_relevances) const
+    {
+        if (!plan.zero_weight_postings)
+        {
+            return;
+        }
+        const size_t relevant_count = std::count_if(document_relevances.begin(), document_relevances.end(),
+            [](const std::pair<uint32_t, double>& document_relevance)
+            {
+                return document_relevance.second > RELEVANCE_TOLERANCE;
+            });
+        if (relevant_count >= plan.result_limit)
+        {
+            return;
+        }
+
+        const std::vector<uint32_t>& documents = plan.zero_weight_postings->documents;
+        const auto first = std::lower_bound(documents.begin(), documents.end(), range.first);
+        const auto last = std::lower_bound(first, documents.end(), range.last);
+        if (QueryMetrics* const metrics = GetMetrics())
+        {
+            metrics->AddPostingsScanned(last - first);
+        }
+
+        std::vector<std::pair<uint32_t, double>> added_documents;
+        auto found_it = document_relevances.begin();
+        for (auto it = first; it != last; ++it)
+        {
+            const uint32_t document = *it;
+            while (found_it != document_relevances.end() && found_it->first < document)
+            {
+                ++found_it;
+            }
+            if ((found_it == document_relevances.end() || found_it->first != document) && IsCandidate(candidates, document)
+                && !excluded_documents.Contains(document) && PassesFilter(document, filter))
+            {
+                added_documents.push_back({document, 0.0});
+            }
+        }
+        if (added_documents.empty())
+        {
+            return;
+        }
+
+        std::vector<std::pair<uint32_t, double>> merged_documents(document_relevances.size() + added_documents.size());
+        std::merge(document_relevances.begin(), document_relevances.end(), added_documents.begin(), added_documents.end(),
+            merged_documents.begin());
+        document_relevances = std::move(merged_documents);
+    }
+
+    // Check if every word of the query has impact-ordered postings and the query has only plus- and minus-words
+    bool CanScoreByImpact(const Query& query) const;
+
+    // Impact-ordered layout of the posting list of the word, built on the first call
+    const ImpactOrderedPostings& GetImpactOrderedPostings(std::string_view word) const;
+
+    // Forget impact-ordered layouts of changed posting lists
+    template <typename WordContainer>
+    void DropImpactOrderedPostings(const WordContainer& words)
+    {
+        if (options_.impact_order_min_postings > 0)
+        {
+            std::lock_guard guard(impact_postings_mutex_);
+            for (const auto& [word, value] : words)
+            {
+                impact_postings_.erase(word);
+            }
+        }
+    }
+
+    // Find the top documents of a TF-IDF query with score-at-a-time evaluation of impact-ordered postings
+    // Tiers of the words are processed from the highest impact (TF * IDF). After every tier the search stops if
+    // neither a new document nor an accumulated document out of the top can get ahead of the top documents
+    // with the impact left. Relevance of the found documents is then calculated exactly by the ordinary posting lists
+    template <typename Filter>
+    std::vector<Document> FindTopDocumentsByImpact(const Query& query, Filter filter) const
+    {
+        QueryMetrics* const metrics = GetMetrics();
+
+        RoaringBitmap excluded_documents;
+        {
+            StageTimer timer(metrics, QueryStage::MINUS_FILTER);
+            excluded_documents = FindExcludedDocuments(query);
+        }
+
+        std::optional<StageTimer> scan_timer(std::in_place, metrics, QueryStage::SCAN);
+        const CollectionStatistics statistics = GetCollectionStatistics();
+
+        struct Cursor
+        {
+            const ImpactOrderedPostings* postings;
+            double weight;
+            size_t tier = 0;
+
+            size_t GetPosition() const
+            {
+                return tier == 0 ? 0 : postings->tier_ends[tier - 1];
+            }
+            bool IsFinished() const
+            {
+                return tier == postings->tier_ends.size();
+            }
+            // Upper bound of the relevance left in the list
+            double GetMaxImpact() const
+            {
+                return IsFinished() ? 0.0 : weight * postings->term_freqs[GetPosition()];
+            }
+        };
+
+        std::vector<Cursor> cursors;
+        for (const std::string_view word : query.plus_words)
+        {
+            const ImpactOrderedPostings& postings = GetImpactOrderedPostings(word);
+            cursors.push_back({&postings, TfIdfScorer::ComputeWeight(statistics, postings.size())});
+        }
+
+        // Relevance is rounded to this tolerance in the order (see GetSortKey), so the bounds keep a margin
+        const double margin = RELEVANCE_TOLERANCE;
+        const size_t top_count = MAX_RESULT_DOCUMENT_COUNT;
+
+        std::unordered_map<uint32_t, double> accumulators;
+        std::vector<double> scores;
+        size_t postings_scanned = 0;
+        while (true)
+        {
+            // The tier with the highest impact goes next
+            const auto cursor_it = std::max_element(cursors.begin(), cursors.end(), [](const Cursor& lhs, const Cursor& rhs)
+                {
+                    return lhs.GetMaxImpact() < rhs.GetMaxImpact();
+                });
+            if (cursor_it->IsFinished())
+            {
+                break;
+            }
+
+            Cursor& cursor = *cursor_it;
+            const size_t tier_end = cursor.postings->tier_ends[cursor.tier];
+            for (size_t i = cursor.GetPosition(); i < tier_end; ++i)
+            {
+                const uint32_t document = cursor.postings->documents[i];
+                if (!excluded_documents.Contains(document) && PassesFilter(document, filter))
+                {
+                    accumulators[document] += TfIdfScorer::Score(cursor.weight, cursor.postings->term_freqs[i], 0, statistics);
+                }
+            }
+            postings_scanned += tier_end - cursor.GetPosition();
+            ++cursor.tier;
+
+            if (accumulators.size() < top_count)
+            {
+                continue;
+            }
+            double impact_left = 0.0;
+            for (const Cursor& other : cursors)
+            {
+                impact_left += other.GetMaxImpact();
+            }
+
+            // Accumulated relevance of the top documents is a lower bound of their relevance,
+            // the best document out of the top can gain at most impact_left
+            scores.clear();
+            for (const auto& [document, relevance] : accumulators)
+            {
+                scores.push_back(relevance);
+            }
+            std::nth_element(scores.begin(), scores.begin() + (top_count - 1), scores.end(), std::greater<>());
+            const double threshold = scores[top_count - 1];
+            const double best_outside = scores.size() > top_count 
+                ? *std::max_element(scores.begin() + top_count, scores.end()) 
+                : 0.0;
+            if (best_outside + impact_left + margin < threshold)
+            {
+                break;
+            }
+        }
+        if (metrics)
+        {
+            metrics->AddPostingsScanned(postings_scanned);
+        }
+        scan_timer.reset();
+
+        // The top documents are selected as by SelectTopDocuments, then their relevance is calculated exactly
+        // and summed in the same order as by FindAllDocuments
+        StageTimer build_timer(metrics, QueryStage::BUILD_RESULT);
+        if (metrics)
+        {
+            metrics->AddCandidates(accumulators.size());
+        }
+        std::vector<Document> accumulated_documents;
+        std::vector<uint32_t> numbers;
+        accumulated_documents.reserve(accumulators.size());
+        numbers.reserve(accumulators.size());
+        for (const auto& [document, relevance] : accumulators)
+        {
+            accumulated_documents.push_back({documents_.GetId(document), relevance, documents_.GetRating(document)});
+            numbers.push_back(document);
+        }
+        std::vector<size_t> order(accumulated_documents.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        const size_t result_count = std::min(order.size(), top_count);
+        std::partial_sort(order.begin(), order.begin() + result_count, order.end(), [&accumulated_documents](size_t lhs, size_t rhs)
+            {
+                return IsMoreRelevant(accumulated_documents[lhs], accumulated_documents[rhs]);
+            });
+
+        // Words go in the outer loop, so the frequencies of a word are read with one check of the precision
+        std::vector<Document> matched_documents;
+        for (size_t i = 0; i < result_count; ++i)
+        {
+            matched_documents.push_back(accumulated_documents[order[i]]);
+            matched_documents.back().relevance = 0.0;
+        }
+        for (const std::string_view word : query.plus_words)
+        {
+            const PostingList& postings = word_to_postings_.at(word);
+            const double weight = TfIdfScorer::ComputeWeight(statistics, postings.size());
+            postings.term_freqs.Visit([&](auto read_term_freq)
+                {
+                    for (size_t i = 0; i < result_count; ++i)
+                    {
+                        const uint32_t document = numbers[order[i]];
+                        const auto it = std::lower_bound(postings.documents.begin(), postings.documents.end(), document);
+                        if (it != postings.documents.end() && *it == document)
+                        {
+                            matched_documents[i].relevance += TfIdfScorer::Score(weight, read_term_freq(it - postings.documents.begin()), 0, statistics);
+                        }
+                    }
+                });
+        }
+        return matched_documents;
+    }
+
+    // Sort only the top documents: first of all by relevance, then by rating. Other documents are dropped
+    // Documents are selected by their packed sort keys (see KeepTopDocuments), so the policy isn't needed
+    template <class ExecutionPolicy>
+    void SelectTopDocuments([[maybe_unused]] ExecutionPolicy&& policy, std::vector<Document>& documents) const
+    {
+        StageTimer timer(GetMetrics(), QueryStage::SORT);
+        KeepTopDocuments(documents, MAX_RESULT_DOCUMENT_COUNT);
+    }
+
+    // Sequenced search stopping at the deadline
+    template <typename Scorer>
+    TopDocumentsResult FindTopDocumentsUntil(const std::string_view raw_query, const DocumentFilter& filter, 
+        const QueryDeadline& deadline) const
+    {
+        QueryMetrics* const metrics = GetMetrics();
+        if (metrics)
+        {
+            metrics->AddQuery();
+        }
+
+        Query query;
+        {
+            StageTimer timer(metrics, QueryStage::PARSE);
+            query = ParseQuery(std::execution::seq, raw_query);
+        }
+
+        TopDocumentsResult result;
+        result.documents = FindAllDocuments<Scorer>(std::execution::seq, query, filter, MAX_RESULT_DOCUMENT_COUNT, deadline);
+        SelectTopDocuments(std::execution::seq, result.documents);
+        result.truncated = deadline.WasExpired();
+        if (metrics && result.truncated)
+        {
+            metrics->AddTruncatedQuery(deadline.WasCancelled());
+        }
+        return result;
+    }
+
+    // Find all documents in SearchServer by query. Filter for filtering documents (predicate) 
+    // result_limit - amount of the most relevant documents the caller needs, other documents may be left out
+    // Note* : cannot use first template with ExecutionPolicy because of avoiding temp copy between two function calls
+    template <typename Scorer, typename Filter>
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, Filter filter,
+        size_t result_limit = std::numeric_limits<size_t>::max(), const QueryDeadline& deadline = QueryDeadline()) const
+    {
+        QueryMetrics* const metrics = GetMetrics();
+
+        // Only documents with all phrases and required words can be found
+        // Documents with minus-words are rejected before scoring
+        const QueryPlan plan = BuildQueryPlan<Scorer>(query, result_limit);
+        Candidates candidates;
+        ExcludedDocuments excluded_documents;
+        {
+            StageTimer timer(metrics, QueryStage::MINUS_FILTER);
+            candidates = FindCandidates(query);
+            if (candidates.is_restricted && candidates.documents.empty())
+            {
+                return {};
+            }
+            excluded_documents = FindExcludedDocuments(plan);
+        }
+
+        return ScoreDocuments<Scorer>(query, plan, candidates, excluded_documents, filter, DocumentRange{}, deadline);
+    }
+
+    // Calculate relevance of documents of the range and build documents of the result in the order of internal numbers
+    // Scoring stops when the deadline expires, documents scored before are returned
+    template <typename Scorer, typename Filter>
+    std::vector<Document> ScoreDocuments(const Query& query, const QueryPlan& plan, const Candidates& candidates,
+        const ExcludedDocuments& excluded_documents, Filter& filter, const DocumentRange& range, const QueryDeadline& deadline) const
+    {
+        const CollectionStatistics& statistics = plan.statistics;
+
+        // Relevance by internal numbers of documents
+        std::map<uint32_t, double> document_to_relevance;
+        const auto add_relevance = [&document_to_relevance](uint32_t document, double relevance)
+        {
+            document_to_relevance[document] += relevance;
+        };
+
+        QueryMetrics* const metrics = GetMetrics();
+
+        // Restricted candidates are cut to the range, so the posting lists are galloped only through them
+        const Candidates* range_candidates = &candidates;
+        Candidates candidates_of_range;
+        if (candidates.is_restricted && (range.first > 0 || range.last < std::numeric_limits<uint32_t>::max()))
+        {
+            candidates_of_range.is_restricted = true;
+            candidates_of_range.documents.assign(
+                std::lower_bound(candidates.documents.begin(), candidates.documents.end(), range.first),
+                std::lower_bound(candidates.documents.begin(), candidates.documents.end(), range.last));
+            range_candidates = &candidates_of_range;
+        }
+
+        // Calculate relevance using the scorer
+        std::optional<StageTimer> scan_timer(std::in_place, metrics, QueryStage::SCAN);
+        std::vector<std::pair<uint32_t, double>> document_relevances;
+        if (plan.info.plus_strategy == PlusStrategy::DOCUMENT_AT_A_TIME)
+        {
+            document_relevances = ScoreWordsByDocument<Scorer>(plan, excluded_documents, filter, range, deadline);
+        }
+        else
+        {
+            for (const PlannedWord& word : plan.words)
+            {
+                if (deadline.IsExpired())
+                {
+                    break;
+                }
+                ScoreWord<Scorer>(word, *range_candidates, excluded_documents, statistics, filter, range, deadline, add_relevance);
+            }
+
+            // Words expanded from prefixes and fuzzy words are merged into one contribution per document
+            for (const auto& expanded_words : query.expanded_words)
+            {
+                if (deadline.IsExpired())
+                {
+                    break;
+                }
+                ScoreExpandedWords<Scorer>(expanded_words, *range_candidates, excluded_documents, statistics, filter, range, deadline, 
+                    add_relevance);
+            }
+            document_relevances.assign(document_to_relevance.begin(), document_to_relevance.end());
+        }
+        if (!deadline.IsExpired())
+        {
+            AddZeroWeightDocuments(plan, *range_candidates, excluded_documents, filter, range, document_relevances);
+        }
+
+        scan_timer.reset();
+
+        // Prepare the result for returning information about all documents upon query, we also filter it
+        StageTimer build_timer(metrics, QueryStage::BUILD_RESULT);
+        if (metrics)
+        {
+            metrics->AddCandidates(document_relevances.size());
+        }
+        std::vector<Document> matched_documents;
+        matched_documents.reserve(document_relevances.size());
+        for (const auto& [document, relevance] : document_relevances)
+        {
+            matched_documents.push_back(
+                {
+                    documents_.GetId(document),
+                    relevance,
+                    documents_.GetRating(document)
+                });
+        }
+
+        // Return result documents
+        return matched_documents;
+    }
+
+    // Find top documents using the pool: heavy queries are scored by ranges of documents in parallel subtasks
+    // Ranges are disjoint and go in the order of internal numbers, so the result is the same as of the sequenced search
+    template <typename Scorer, typename Filter>
+    std::vector<Document> FindTopDocumentsInPool(ThreadPool& pool, const std::string_view raw_query, Filter filter) const
+    {
+        QueryMetrics* const metrics = GetMetrics();
+        if (metrics)
+        {
+            metrics->AddQuery();
+        }
+
+        Query query;
+        {
+            StageTimer timer(metrics, QueryStage::PARSE);
+            query = ParseQuery(std::execution::seq, raw_query);
+        }
+
+        const QueryPlan plan = BuildQueryPlan<Scorer>(query, MAX_RESULT_DOCUMENT_COUNT);
+        Candidates candidates;
+        ExcludedDocuments excluded_documents;
+        {
+            StageTimer timer(metrics, QueryStage::MINUS_FILTER);
+            candidates = FindCandidates(query);
+            if (candidates.is_restricted && candidates.documents.empty())
+            {
+                return {};
+            }
+            excluded_documents = FindExcludedDocuments(plan);
+        }
+
+        const QueryDeadline no_deadline;
+        const size_t range_count = GetRangeCount(query, candidates, pool.GetThreadCount());
+        std::vector<Document> matched_documents;
+        if (range_count <= 1)
+        {
+            matched_documents = ScoreDocuments<Scorer>(query, plan, candidates, excluded_documents, filter, DocumentRange{}, 
+                no_deadline);
+        }
+        else
+        {
+            const uint64_t number_count = documents_.GetNumberCount();
+            std::vector<std::vector<Document>> range_documents(range_count);
+            pool.ParallelFor(range_count, [&](size_t i)
+                {
+                    DocumentRange range;
+                    range.first = static_cast<uint32_t>(number_count * i / range_count);
+                    if (i + 1 < range_count)
+                    {
+                        range.last = static_cast<uint32_t>(number_count * (i + 1) / range_count);
+                    }
+                    // Every subtask has its own copy of the filter: predicates may have state
+                    Filter range_filter = filter;
+                    // Every range keeps its top, so the top of the union is the top of the query
+                    range_documents[i] = ScoreDocuments<Scorer>(query, plan, candidates, excluded_documents, range_filter, range,
+                        no_deadline);
+                });
+            for (auto& documents : range_documents)
+            {
+                matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+            }
+        }
+
+        SelectTopDocuments(std::execution::seq, matched_documents);
+        return matched_documents;
+    }
+
+    template <typename Scorer, typename Filter>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, Filter filter,
+        size_t result_limit = std::numeric_limits<size_t>::max()) const
+    {
+        // Relevance by internal numbers of documents
+        ConcurrentMap<uint32_t, double> document_to_relevance;
+        const auto add_relevance = [&document_to_relevance](uint32_t document, double relevance)
+        {
+            document_to_relevance[document].ref_to_value += relevance;
+        };
+
+        QueryMetrics* const metrics = GetMetrics();
+
+        // Only documents with all phrases and required words can be found
+        // Documents with minus-words are rejected before scoring
+        const QueryPlan plan = BuildQueryPlan<Scorer>(query, result_limit);
+        Candidates candidates;
+        ExcludedDocuments excluded_documents;
+        {
+            StageTimer timer(metrics, QueryStage::MINUS_FILTER);
+            candidates = FindCandidates(query);
+            if (candidates.is_restricted && candidates.documents.empty())
+            {
+                return {};
+            }
+            excluded_documents = FindExcludedDocuments(plan);
+        }
+
+        // Calculate relevance using the scorer, words are scored term at a time in parallel
+        std::optional<StageTimer> scan_timer(std::in_place, metrics, QueryStage::SCAN);
+        const CollectionStatistics& statistics = plan.statistics;
+        const QueryDeadline no_deadline;
+        std::for_each(
+            std::execution::par,
+            plan.words.begin(), plan.words.end(),
+            [&](const PlannedWord& word)
+            {
+                ScoreWord<Scorer>(word, candidates, excluded_documents, statistics, filter, DocumentRange{}, no_deadline, add_relevance);
+            }
+        );
+
+        // Words expanded from prefixes and fuzzy words are merged into one contribution per document
+        std::for_each(
+            std::execution::par,
+            query.expanded_words.begin(), query.expanded_words.end(),
+            [&](const auto& expanded_words)
+            {
+                ScoreExpandedWords<Scorer>(expanded_words, candidates, excluded_documents, statistics, filter, DocumentRange{}, no_deadline, add_relevance);
+            }
+        );
+        const auto document_to_relevance_map = document_to_relevance.BuildOrdinaryMap();
+        std::vector<std::pair<uint32_t, double>> document_relevances(document_to_relevance_map.begin(), document_to_relevance_map.end());
+        AddZeroWeightDocuments(plan, candidates, excluded_documents, filter, DocumentRange{}, document_relevances);
+        scan_timer.reset();
+
+        // Prepare the result for returning information about all documents upon query, we also filter it
+        StageTimer build_timer(metrics, QueryStage::BUILD_RESULT);
+        if (metrics)
+        {
+            metrics->AddCandidates(document_relevances.size());
+        }
+        std::vector<Document> matched_documents;
+        matched_documents.reserve(document_relevances.size());
+        for (const auto& [document, relevance] : document_relevances)
+        {
+            matched_documents.push_back(
+                {
+                    documents_.GetId(document),
+                    relevance,
+                    documents_.GetRating(document)
+                });
+        }
+
+        // Return result documents
+        return matched_documents;
+    }
+
+
+private:
+
+    // Options of the server
+    SearchServerOptions options_;
+
+    // Set of stop words
+    StopWordSet stop_words_;
+
+    // Strings of all words of documents. Index structures below store views to them
+    TermDictionary term_dictionary_;
+
+    // Data structure that stores information about each word:
+    // internal numbers of documents where this word occurs, share in these documents 
+    // Hash table by the word, so a word of a query is resolved with one probe; posting lists never move
+    TermHashMap<PostingList> word_to_postings_;
+
+    // Data structure that stores information about each document:
+    // Key - id of a document, value - map of words frequencies
+    // Filled only with ForwardIndexMode::FULL
+    std::pmr::map<int, std::pmr::map<std::string_view, double>> document_to_word_freqs_;
+
+    // Sorted ids of words of every document by internal number, filled only with ForwardIndexMode::COMPACT
+    std::vector<std::vector<uint32_t>> document_terms_;
+
+    // Metadata of documents by columns: id, status, rating, ... 
+    DocumentStore documents_;
+
+    // Amount of documents
+    size_t document_count_ = 0;
+
+    // Sum of amounts of words of all documents (for average length of a document)
+    size_t total_word_count_ = 0;
 
     // History of adding documents
-    std::set<int> document_ids_;
+    std::pmr::set<int> document_ids_;
+
+    // Positions of words in documents for phrase queries
+    PositionalIndex positional_index_;
+
+    // Metrics of queries, collected only if SearchServerOptions::collect_query_metrics is on
+    mutable QueryMetrics metrics_;
+
+    // Version of the index for checking if search results are still actual
+    uint64_t index_version_ = 0;
+
+    // Results of the last query of FindTopDocumentsPage
+    struct PageCacheEntry
+    {
+        std::string raw_query;
+        DocumentFilter filter;
+        std::type_index scorer;
+        SearchResults results;
+    };
+    mutable std::mutex page_cache_mutex_;
+    mutable std::optional<PageCacheEntry> page_cache_;
+
+    // Impact-ordered layouts of long posting lists (see SearchServerOptions::impact_order_min_postings)
+    // Built by queries, so only added under the mutex; dropped by AddDocument and RemoveDocument
+    mutable std::mutex impact_postings_mutex_;
+    mutable std::map<std::string_view, ImpactOrderedPostings> impact_postings_;
+
+    // Pool for batches of queries, created on the first use. Declared last to be stopped before other members are destroyed
+    mutable std::once_flag thread_pool_flag_;
+    mutable std::unique_ptr<ThreadPool> thread_pool_;
 };
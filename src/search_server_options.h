@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+#include "term_freq_column.h"
+
+// SearchServerOptions - settings of the search server that are fixed at construction
+
+// Storage of words of every document, used by GetWordFrequencies, MatchDocument and RemoveDocument
+enum class ForwardIndexMode
+{
+    FULL,       // map of words and term frequencies per document: the fastest, the largest
+    COMPACT,    // sorted array of ids of words per document, term frequencies are taken from the posting lists
+    NONE,       // no forward index: words of a document are found by a scan of all posting lists
+};
+
+struct SearchServerOptions
+{
+    // Store positions of words in documents to answer phrase queries ("high availability")
+    // Can be switched off to save memory when phrase search is not needed
+    bool use_positional_index = true;
+
+    // Maximum amount of dictionary words a prefix query term (serv*) is expanded to, minus-terms are expanded to all words
+    size_t max_prefix_expansions = 50;
+
+    // Maximum amount of dictionary words a fuzzy query term (word~ or word~2) is expanded to
+    // The closest words are taken, minus-terms are expanded to all words
+    size_t max_fuzzy_expansions = 50;
+
+    // Weights in the relevance of words found by a fuzzy term, index is the edit distance
+    std::array<double, 3> fuzzy_distance_weights = {1.0, 0.5, 0.25};
+
+    // Memory for nodes of maps and sets of the index (postings, forward index, ids, dictionary, positions)
+    // nullptr - the global allocator; IndexMemoryResource pools nodes by size. Must outlive the server
+    std::pmr::memory_resource* memory_resource = nullptr;
+
+    // Precision of term frequencies in posting lists: DOUBLE - exact, FLOAT - half of the memory,
+    // UINT8 - an eighth, a frequency differs from the exact one by at most the quantization step of its term
+    TermFreqPrecision term_freq_precision = TermFreqPrecision::DOUBLE;
+
+    // RemoveDocument compacts internal numbers of documents (see SearchServer::Compact)
+    // when numbers of removed documents are more than this share of all given numbers, 0 - only by Compact
+    double compaction_removed_share = 0.0;
+
+    // Storage of words of every document (see ForwardIndexMode)
+    ForwardIndexMode forward_index = ForwardIndexMode::FULL;
+
+    // Record durations of stages of queries and counters (see SearchServer::GetQueryMetrics)
+    // Switched off, it costs a check of the flag per stage
+    bool collect_query_metrics = false;
+
+    // Threads of the pool executing batches of queries (see SearchServer::FindTopDocumentsBatch), 0 - one per hardware thread
+    size_t query_threads = 0;
+
+    // A query of a batch is split into one subtask per this amount of postings to scan (at most one per thread)
+    // 0 - queries are never split
+    size_t split_query_postings = 100000;
+
+    // Posting lists of at least this many documents get a secondary layout sorted by term frequency (impact order).
+    // FindTopDocuments with TF-IDF uses it when all words of the query have such lists, and stops scanning
+    // when the rest of the lists can't change the top documents. 0 - switched off
+    // A layout is built on the first query using the word and rebuilt after changes of the list
+    size_t impact_order_min_postings = 0;
+};
@@ -0,0 +1,303 @@
+#include "segmented_search_server.h"
+
+#include <map>
+#include <stdexcept>
+
+
+// ------------------------------- Constructors ------------------------------- //
+
+SegmentedSearchServer::SegmentedSearchServer(std::string_view stop_words_text, const SegmentedIndexOptions& options)
+    : options_(options)
+{
+    if (options_.seal_document_count == 0 || options_.merge_factor < 2)
+    {
+        throw std::invalid_argument("Error! Invalid options of segments!");
+    }
+
+    std::vector<std::string> words;
+    for (const std::string_view word : SPI(stop_words_text))
+    {
+        if (!word.empty())
+        {
+            if (!SearchServer::IsValidWord(word))
+            {
+                throw std::invalid_argument("Error! Line has invalid symbols!");
+            }
+            words.emplace_back(word);
+        }
+    }
+    stop_words_ = StopWordSet(std::move(words));
+
+    merge_thread_ = std::thread([this]()
+        {
+            MergeLoop();
+        });
+}
+
+SegmentedSearchServer::~SegmentedSearchServer()
+{
+    {
+        std::lock_guard lock(mutex_);
+        is_stopped_ = true;
+    }
+    merge_cv_.notify_all();
+    merge_thread_.join();
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    if (!SearchServer::IsValidWord(document))
+    {
+        throw std::invalid_argument("Error! Line has invalid symbols!");
+    }
+
+    // Frequencies are computed before the lock
+    const auto words = SplitIntoWordsNoStop(document);
+    std::map<std::string_view, int> document_word_counts;
+    for (const std::string_view word : words)
+    {
+        ++document_word_counts[word];
+    }
+    std::vector<std::pair<std::string_view, double>> word_freqs;
+    word_freqs.reserve(document_word_counts.size());
+    for (const auto& [word, count] : document_word_counts)
+    {
+        word_freqs.push_back({word, count / static_cast<double>(words.size())});
+    }
+
+    std::lock_guard lock(mutex_);
+    const bool is_added = memory_segment_.Contains(document_id) || std::any_of(segments_.begin(), segments_.end(),
+        [document_id](const auto& segment)
+        {
+            return segment->Contains(document_id);
+        });
+    if (document_id < 0 || is_added)
+    {
+        throw std::invalid_argument("Error! Invalid id of document!");
+    }
+
+    memory_segment_.AddDocument({document_id, status, SearchServer::ComputeAverageRating(ratings)}, word_freqs);
+    if (memory_segment_.size() >= options_.seal_document_count)
+    {
+        SealMemorySegment();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id)
+{
+    std::lock_guard lock(mutex_);
+    if (memory_segment_.RemoveDocument(document_id))
+    {
+        return;
+    }
+    for (const auto& segment : segments_)
+    {
+        if (segment->RemoveDocument(document_id))
+        {
+            return;
+        }
+    }
+}
+
+void SegmentedSearchServer::Flush()
+{
+    std::lock_guard lock(mutex_);
+    SealMemorySegment();
+}
+
+void SegmentedSearchServer::WaitForMerges()
+{
+    std::unique_lock lock(mutex_);
+    idle_cv_.wait(lock, [this]()
+        {
+            return is_stopped_ || (!is_merging_ && PickMerge().second == 0);
+        });
+}
+
+void SegmentedSearchServer::ForceMerge()
+{
+    std::unique_lock lock(mutex_);
+    SealMemorySegment();
+    idle_cv_.wait(lock, [this]()
+        {
+            return !is_merging_;
+        });
+
+    // A single segment is merged too, to drop its removed documents
+    if (segments_.size() > 1 || (segments_.size() == 1 && segments_.front()->GetRemovedCount() > 0))
+    {
+        is_merging_ = true;
+        RunMerge(lock, 0, segments_.size());
+        is_merging_ = false;
+        idle_cv_.notify_all();
+        merge_cv_.notify_all();
+    }
+}
+
+int SegmentedSearchServer::GetDocumentCount() const
+{
+    std::lock_guard lock(mutex_);
+    size_t count = memory_segment_.GetDocumentCount();
+    for (const auto& segment : segments_)
+    {
+        count += segment->GetDocumentCount();
+    }
+    return static_cast<int>(count);
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const
+{
+    std::lock_guard lock(mutex_);
+    return segments_.size();
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+SegmentedSearchServer::Query SegmentedSearchServer::ParseQuery(std::string_view text) const
+{
+    if (!SearchServer::IsValidWord(text))
+    {
+        throw std::invalid_argument("Error! Line has invalid symbols!");
+    }
+
+    Query query;
+    for (std::string_view word : SPI(text))
+    {
+        if (word.empty())
+        {
+            continue;
+        }
+        bool is_minus = false;
+        if (word[0] == '-')
+        {
+            is_minus = true;
+            word.remove_prefix(1);
+            if (word.empty() || word[0] == '-')
+            {
+                throw std::invalid_argument("Error! Invalid minus-word!");
+            }
+        }
+        if (stop_words_.Contains(word))
+        {
+            continue;
+        }
+        (is_minus ? query.minus_words : query.plus_words).push_back(word);
+    }
+
+    for (std::vector<std::string_view>* words : {&query.plus_words, &query.minus_words})
+    {
+        std::sort(words->begin(), words->end());
+        words->erase(std::unique(words->begin(), words->end()), words->end());
+    }
+    return query;
+}
+
+std::vector<std::string_view> SegmentedSearchServer::SplitIntoWordsNoStop(std::string_view text) const
+{
+    std::vector<std::string_view> words;
+    for (const std::string_view word : SPI(text))
+    {
+        if (!stop_words_.Contains(word))
+        {
+            words.push_back(word);
+        }
+    }
+    return words;
+}
+
+void SegmentedSearchServer::SealMemorySegment()
+{
+    if (memory_segment_.size() == 0)
+    {
+        return;
+    }
+    if (memory_segment_.GetDocumentCount() > 0)
+    {
+        segments_.push_back(IndexSegment::Seal(memory_segment_));
+    }
+    memory_segment_ = MemorySegment();
+    merge_cv_.notify_all();
+}
+
+size_t SegmentedSearchServer::GetTier(size_t document_count) const
+{
+    size_t tier = 0;
+    for (size_t bound = options_.seal_document_count * options_.merge_factor; document_count >= bound; bound *= options_.merge_factor)
+    {
+        ++tier;
+    }
+    return tier;
+}
+
+std::pair<size_t, size_t> SegmentedSearchServer::PickMerge() const
+{
+    // Adjacent segments of one tier, the smallest tier first
+    std::pair<size_t, size_t> best = {0, 0};
+    size_t best_tier = 0;
+    size_t run_first = 0;
+    for (size_t i = 0; i < segments_.size(); ++i)
+    {
+        const size_t tier = GetTier(segments_[i]->size());
+        if (i > 0 && tier != GetTier(segments_[i - 1]->size()))
+        {
+            run_first = i;
+        }
+        if (i + 1 - run_first == options_.merge_factor && (best.second == 0 || tier < best_tier))
+        {
+            best = {run_first, options_.merge_factor};
+            best_tier = tier;
+        }
+    }
+    return best;
+}
+
+void SegmentedSearchServer::RunMerge(std::unique_lock<std::mutex>& lock, size_t first, size_t count)
+{
+    // Only the merge changes the segments before the end of the list, so [first, first + count) stays in place
+    const std::vector<std::shared_ptr<const IndexSegment>> sources_segments(segments_.begin() + first, segments_.begin() + first + count);
+    lock.unlock();
+
+    std::vector<IndexSegment::Source> sources;
+    std::shared_ptr<IndexSegment> merged = IndexSegment::Merge(sources_segments, sources);
+
+    lock.lock();
+    for (uint32_t number = 0; number < sources.size(); ++number)
+    {
+        if (sources_segments[sources[number].segment]->IsRemoved(sources[number].number))
+        {
+            merged->RemoveNumber(number);
+        }
+    }
+    segments_.erase(segments_.begin() + first, segments_.begin() + first + count);
+    if (merged->size() > 0)
+    {
+        segments_.insert(segments_.begin() + first, std::move(merged));
+    }
+}
+
+void SegmentedSearchServer::MergeLoop()
+{
+    std::unique_lock lock(mutex_);
+    while (true)
+    {
+        merge_cv_.wait(lock, [this]()
+            {
+                return is_stopped_ || (!is_merging_ && PickMerge().second > 0);
+            });
+        if (is_stopped_)
+        {
+            break;
+        }
+
+        const auto [first, count] = PickMerge();
+        is_merging_ = true;
+        RunMerge(lock, first, count);
+        is_merging_ = false;
+        idle_cv_.notify_all();
+    }
+    idle_cv_.notify_all();
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+// SegmentedSearchServer - TF-IDF search over an index split into segments (LSM-style)
+// New documents go to a small mutable memory segment. When it has seal_document_count documents, it is sealed
+// into an immutable IndexSegment, so writes never touch the segments which are being read.
+// A background thread merges sealed segments by a tiered policy: segments of tier t have at least
+// seal_document_count * merge_factor^t documents, and merge_factor segments of one tier are merged into a segment of the next tier.
+// A query reads a snapshot of the list of segments, scores every segment and merges the results.
+// Removed documents of sealed segments are marked by tombstones and are dropped by merges. Until then they are still counted
+// in the statistics of the collection (amount of documents and document frequencies), as in other LSM indexes,
+// so relevance is exactly the one of SearchServer when no documents are removed or after ForceMerge.
+// Queries have plus-words and minus-words (-word).
+// The server is thread-safe: documents can be added and removed while queries run on other threads.
+
+#include "dense_bitset.h"
+#include "document.h"
+#include "index_segment.h"
+#include "scoring.h"
+#include "search_results.h"
+#include "search_server.h"
+#include "stop_word_set.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct SegmentedIndexOptions
+{
+    // Documents of the memory segment when it is sealed
+    size_t seal_document_count = 4096;
+
+    // Segments of one tier merged at once
+    size_t merge_factor = 4;
+};
+
+class SegmentedSearchServer
+{
+    // Plus-words and minus-words of a query, sorted without repeats
+    struct Query
+    {
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+    };
+
+public:
+    explicit SegmentedSearchServer(std::string_view stop_words_text, const SegmentedIndexOptions& options = SegmentedIndexOptions());
+
+    // Stops the merges, a merge in progress is finished
+    ~SegmentedSearchServer();
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    // Add document
+    // Params - id, content, status, rating
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Nothing happens if there is no such document
+    void RemoveDocument(int document_id);
+
+    // Seal the memory segment
+    void Flush();
+
+    // Wait until no merge is running or pending
+    void WaitForMerges();
+
+    // Flush and merge all segments into one, dropping removed documents
+    void ForceMerge();
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, Predicate predicate) const
+    {
+        const Query query = ParseQuery(raw_query);
+
+        // Segments are immutable, so they are scored without the lock (except tombstones, which are atomic)
+        std::vector<std::shared_ptr<const IndexSegment>> segments;
+        std::vector<double> idfs;
+        std::vector<Document> matched_documents;
+        {
+            std::lock_guard lock(mutex_);
+            segments.assign(segments_.begin(), segments_.end());
+
+            CollectionStatistics statistics;
+            statistics.document_count = memory_segment_.GetDocumentCount();
+            for (const auto& segment : segments)
+            {
+                statistics.document_count += segment->size();
+            }
+            for (const std::string_view word : query.plus_words)
+            {
+                size_t document_freq = memory_segment_.GetDocumentFreq(word);
+                for (const auto& segment : segments)
+                {
+                    document_freq += segment->GetDocumentFreq(word);
+                }
+                idfs.push_back(document_freq == 0 ? 0.0 : TfIdfScorer::ComputeWeight(statistics, document_freq));
+            }
+
+            CollectDocuments(memory_segment_, query, idfs, predicate, matched_documents);
+        }
+        for (const auto& segment : segments)
+        {
+            CollectDocuments(*segment, query, idfs, predicate, matched_documents);
+        }
+
+        KeepTopDocuments(matched_documents, MAX_RESULT_DOCUMENT_COUNT);
+        return matched_documents;
+    }
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const
+    {
+        return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int)
+            {
+                return document_status == status;
+            });
+    }
+
+    // Documents which are not removed
+    int GetDocumentCount() const;
+
+    // Sealed segments
+    size_t GetSegmentCount() const;
+
+private:
+    Query ParseQuery(std::string_view text) const;
+
+    // Words of the document without stop words
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+
+    // Documents of one segment matching the query, which are not removed
+    template <typename Segment, typename Predicate>
+    static void CollectDocuments(const Segment& segment, const Query& query, const std::vector<double>& idfs, Predicate& predicate,
+        std::vector<Document>& matched_documents)
+    {
+        DenseBitset excluded;
+        for (const std::string_view word : query.minus_words)
+        {
+            segment.ForEachLivePosting(word, [&excluded](uint32_t number, double)
+                {
+                    excluded.Set(number);
+                });
+        }
+
+        std::vector<double> relevances(segment.size(), 0.0);
+        DenseBitset found;
+        for (size_t i = 0; i < query.plus_words.size(); ++i)
+        {
+            const double idf = idfs[i];
+            segment.ForEachLivePosting(query.plus_words[i], [&](uint32_t number, double term_freq)
+                {
+                    if (!excluded.Test(number))
+                    {
+                        relevances[number] += term_freq * idf;
+                        found.Set(number);
+                    }
+                });
+        }
+
+        for (uint32_t number = 0; number < segment.size(); ++number)
+        {
+            if (found.Test(number))
+            {
+                const SegmentDocument document = segment.GetDocument(number);
+                if (predicate(document.id, document.status, document.rating))
+                {
+                    matched_documents.emplace_back(document.id, relevances[number], document.rating);
+                }
+            }
+        }
+    }
+
+    // Seal the memory segment and wake the merge thread, the mutex must be locked
+    void SealMemorySegment();
+
+    // Index of the first segment of a merge and amount of the segments, 0 if there is nothing to merge
+    std::pair<size_t, size_t> PickMerge() const;
+
+    // Tier of a segment by its size
+    size_t GetTier(size_t document_count) const;
+
+    // Merge segments [first, first + count) outside the lock, then replace them by the result
+    // Documents removed while the merge ran get tombstones in the result
+    void RunMerge(std::unique_lock<std::mutex>& lock, size_t first, size_t count);
+
+    void MergeLoop();
+
+    const SegmentedIndexOptions options_;
+    StopWordSet stop_words_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable merge_cv_;      // a merge can be picked or the server stops
+    std::condition_variable idle_cv_;       // a merge is finished
+    MemorySegment memory_segment_;
+    std::vector<std::shared_ptr<IndexSegment>> segments_;   // in the order of adding documents
+    bool is_merging_ = false;
+    bool is_stopped_ = false;
+
+    std::thread merge_thread_;
+};
@@ -0,0 +1,37 @@
+#include "stop_word_set.h"
+#include "memory_stats.h"
+
+
+// ------------------------------- Constructors ------------------------------- //
+
+StopWordSet::StopWordSet(std::vector<std::string> words)
+    : words_(std::move(words))
+{
+    std::sort(words_.begin(), words_.end());
+    words_.erase(std::unique(words_.begin(), words_.end()), words_.end());
+    for (const std::string& word : words_)
+    {
+        length_mask_ |= GetStopWordLengthBit(word.size());
+    }
+
+    slots_.resize(GetStopWordTableSize(words_.size()));
+    displacements_.resize(GetStopWordBucketCount(words_.size()));
+    std::vector<uint32_t> scratch(GetStopWordScratchSize(words_.size(), displacements_.size()));
+    if (!BuildStopWordTable(words_, slots_, displacements_, scratch))
+    {
+        throw std::invalid_argument("Error! No perfect hash for the stop words!");
+    }
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+size_t StopWordSet::GetMemoryUsage() const
+{
+    size_t bytes = words_.capacity() * sizeof(std::string);
+    for (const std::string& word : words_)
+    {
+        bytes += GetStringHeapBytes(word);
+    }
+    return bytes + slots_.capacity() * sizeof(uint32_t) + displacements_.capacity() * sizeof(uint32_t);
+}
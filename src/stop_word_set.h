@@ -0,0 +1,301 @@
+#pragma once
+
+// StopWordSet - immutable set of stop words with perfect hashing
+// Every token of every document and query is checked, so a lookup is a bit test of the length of the word,
+// two hashes and at most one comparison of strings.
+// Perfect hashing is hash and displace: words are split into buckets by one hash, every bucket gets
+// the smallest displacement (seed of the second hash) that puts its words into free slots of the table.
+// StaticStopWordSet builds the same table at compile time for a fixed list of words:
+//     constexpr auto STOP_WORDS = MakeStopWordSet("a", "the", "and");
+//     static_assert(STOP_WORDS.Contains("the"));
+//     SearchServer search_server(STOP_WORDS);
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Value of an empty slot of a table of stop words
+const uint32_t NO_STOP_WORD = UINT32_MAX;
+
+// Displacements tried for a bucket before the build fails
+const uint32_t MAX_STOP_WORD_DISPLACEMENT = 1u << 16;
+
+// Hash of a word with a seed (FNV-1a), the same at compile time and at run time
+constexpr uint64_t HashStopWord(std::string_view word, uint64_t seed)
+{
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (const char c : word)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+// Bit of the mask of lengths of the words, long words share the last bit
+constexpr uint64_t GetStopWordLengthBit(size_t length)
+{
+    return uint64_t{1} << std::min<size_t>(length, 63);
+}
+
+// Table has a power of two slots, at least twice as many as the words
+constexpr size_t GetStopWordTableSize(size_t word_count)
+{
+    size_t size = 1;
+    while (size < 2 * word_count)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+// About two words per bucket
+constexpr size_t GetStopWordBucketCount(size_t word_count)
+{
+    size_t count = 1;
+    while (count * 2 < word_count)
+    {
+        count *= 2;
+    }
+    return count;
+}
+
+// Size of the scratch buffer of BuildStopWordTable: bucket of every word, words by bucket,
+// starts of buckets, buckets by size and starts of sizes
+constexpr size_t GetStopWordScratchSize(size_t word_count, size_t bucket_count)
+{
+    return 3 * word_count + 2 * bucket_count + 3;
+}
+
+// Fill slots (indexes of words) and displacements of buckets, sizes of both are powers of two
+// Words are grouped by bucket and buckets are ordered by size with counting sorts, so every word is hashed
+// with seed 0 once and a displacement is tried only on the words of its bucket: the build takes O(W * D),
+// where D is the average amount of displacements tried. Scratch has GetStopWordScratchSize elements
+// Buckets go from the largest one, repeated words take the slot of the first one
+// Return false if a bucket got no displacement
+template <typename Words, typename Slots, typename Displacements, typename Scratch>
+constexpr bool BuildStopWordTable(const Words& words, Slots& slots, Displacements& displacements, Scratch& scratch)
+{
+    const size_t word_count = words.size();
+    const size_t bucket_count = displacements.size();
+    const size_t table_mask = slots.size() - 1;
+    for (auto& slot : slots)
+    {
+        slot = NO_STOP_WORD;
+    }
+
+    // Parts of the scratch buffer
+    const size_t word_buckets = 0;
+    const size_t members = word_count;
+    const size_t bucket_starts = 2 * word_count;
+    const size_t bucket_order = bucket_starts + bucket_count + 1;
+    const size_t size_starts = bucket_order + bucket_count;
+
+    // Words of bucket b are scratch[members + k] for k in [bucket_starts[b], bucket_starts[b + 1]), in the order of words
+    for (size_t bucket = 0; bucket <= bucket_count; ++bucket)
+    {
+        scratch[bucket_starts + bucket] = 0;
+    }
+    for (size_t i = 0; i < word_count; ++i)
+    {
+        const uint32_t bucket = static_cast<uint32_t>(HashStopWord(words[i], 0) & (bucket_count - 1));
+        scratch[word_buckets + i] = bucket;
+        ++scratch[bucket_starts + bucket + 1];
+    }
+    for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        scratch[bucket_starts + bucket + 1] += scratch[bucket_starts + bucket];
+        scratch[bucket_order + bucket] = scratch[bucket_starts + bucket];     // next place of the bucket
+    }
+    for (size_t i = 0; i < word_count; ++i)
+    {
+        scratch[members + scratch[bucket_order + scratch[word_buckets + i]]++] = static_cast<uint32_t>(i);
+    }
+
+    // Buckets from the largest one: sorted by word_count - size
+    const auto get_bucket_size = [&scratch, bucket_starts](size_t bucket)
+    {
+        return scratch[bucket_starts + bucket + 1] - scratch[bucket_starts + bucket];
+    };
+    for (size_t key = 0; key <= word_count + 1; ++key)
+    {
+        scratch[size_starts + key] = 0;
+    }
+    for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        ++scratch[size_starts + word_count - get_bucket_size(bucket) + 1];
+    }
+    for (size_t key = 0; key <= word_count; ++key)
+    {
+        scratch[size_starts + key + 1] += scratch[size_starts + key];
+    }
+    for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        scratch[bucket_order + scratch[size_starts + word_count - get_bucket_size(bucket)]++] = static_cast<uint32_t>(bucket);
+    }
+
+    for (size_t order = 0; order < bucket_count; ++order)
+    {
+        const size_t bucket = scratch[bucket_order + order];
+        const size_t first = scratch[bucket_starts + bucket];
+        const size_t last = scratch[bucket_starts + bucket + 1];
+        if (first == last)
+        {
+            break;
+        }
+
+        bool is_placed = false;
+        for (uint32_t displacement = 1; !is_placed; ++displacement)
+        {
+            if (displacement > MAX_STOP_WORD_DISPLACEMENT)
+            {
+                return false;
+            }
+
+            // Words of the bucket are placed one by one and taken back if one of them collides
+            is_placed = true;
+            for (size_t k = first; k < last && is_placed; ++k)
+            {
+                const uint32_t i = scratch[members + k];
+                auto& slot = slots[HashStopWord(words[i], displacement) & table_mask];
+                if (slot == NO_STOP_WORD)
+                {
+                    slot = i;
+                }
+                else if (std::string_view(words[slot]) != std::string_view(words[i]))
+                {
+                    is_placed = false;
+                }
+            }
+            if (!is_placed)
+            {
+                for (size_t k = first; k < last; ++k)
+                {
+                    const uint32_t i = scratch[members + k];
+                    auto& slot = slots[HashStopWord(words[i], displacement) & table_mask];
+                    if (slot == i)
+                    {
+                        slot = NO_STOP_WORD;
+                    }
+                }
+            }
+            displacements[bucket] = displacement;
+        }
+    }
+    return true;
+}
+
+// Set of stop words fixed at compile time
+template <size_t N>
+class StaticStopWordSet
+{
+public:
+    static constexpr size_t TABLE_SIZE = GetStopWordTableSize(N);
+    static constexpr size_t BUCKET_COUNT = GetStopWordBucketCount(N);
+
+    constexpr explicit StaticStopWordSet(const std::array<std::string_view, N>& words)
+        : words_(words)
+    {
+        for (const std::string_view word : words_)
+        {
+            length_mask_ |= GetStopWordLengthBit(word.size());
+        }
+        std::array<uint32_t, GetStopWordScratchSize(N, BUCKET_COUNT)> scratch = {};
+        if (!BuildStopWordTable(words_, slots_, displacements_, scratch))
+        {
+            throw std::invalid_argument("Error! No perfect hash for the stop words!");
+        }
+    }
+
+    constexpr bool Contains(std::string_view word) const
+    {
+        if ((length_mask_ & GetStopWordLengthBit(word.size())) == 0)
+        {
+            return false;
+        }
+        const uint32_t displacement = displacements_[HashStopWord(word, 0) & (BUCKET_COUNT - 1)];
+        const uint32_t slot = slots_[HashStopWord(word, displacement) & (TABLE_SIZE - 1)];
+        return slot != NO_STOP_WORD && words_[slot] == word;
+    }
+
+    constexpr const std::array<std::string_view, N>& GetWords() const
+    {
+        return words_;
+    }
+
+    constexpr const std::array<uint32_t, TABLE_SIZE>& GetSlots() const
+    {
+        return slots_;
+    }
+
+    constexpr const std::array<uint32_t, BUCKET_COUNT>& GetDisplacements() const
+    {
+        return displacements_;
+    }
+
+    constexpr uint64_t GetLengthMask() const
+    {
+        return length_mask_;
+    }
+
+private:
+    std::array<std::string_view, N> words_ = {};
+    std::array<uint32_t, TABLE_SIZE> slots_ = {};
+    std::array<uint32_t, BUCKET_COUNT> displacements_ = {};
+    uint64_t length_mask_ = 0;
+};
+
+template <typename... Words>
+constexpr StaticStopWordSet<sizeof...(Words)> MakeStopWordSet(Words... words)
+{
+    return StaticStopWordSet<sizeof...(Words)>(std::array<std::string_view, sizeof...(Words)>{std::string_view(words)...});
+}
+
+// Set of stop words built at run time
+class StopWordSet
+{
+public:
+    StopWordSet() = default;
+
+    // Repeated words are stored once
+    explicit StopWordSet(std::vector<std::string> words);
+
+    // Tables are copied from the set built at compile time
+    template <size_t N>
+    explicit StopWordSet(const StaticStopWordSet<N>& words)
+        : words_(words.GetWords().begin(), words.GetWords().end())
+        , slots_(words.GetSlots().begin(), words.GetSlots().end())
+        , displacements_(words.GetDisplacements().begin(), words.GetDisplacements().end())
+        , length_mask_(words.GetLengthMask())
+    {
+    }
+
+    bool Contains(std::string_view word) const
+    {
+        if ((length_mask_ & GetStopWordLengthBit(word.size())) == 0)
+        {
+            return false;
+        }
+        const uint32_t displacement = displacements_[HashStopWord(word, 0) & (displacements_.size() - 1)];
+        const uint32_t slot = slots_[HashStopWord(word, displacement) & (slots_.size() - 1)];
+        return slot != NO_STOP_WORD && words_[slot] == word;
+    }
+
+    const std::vector<std::string>& GetWords() const
+    {
+        return words_;
+    }
+
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<std::string> words_;
+    std::vector<uint32_t> slots_;
+    std::vector<uint32_t> displacements_;
+    uint64_t length_mask_ = 0;
+};
@@ -0,0 +1,177 @@
+#include "term_dictionary.h"
+#include "memory_stats.h"
+
+#include <iterator>
+
+namespace
+{
+    // Recently added words are merged into the sorted array when there are more than
+    // max(MIN_RECENT_TERMS, sorted words / RECENT_TERMS_RATIO) of them,
+    // so the merge costs amortized O(1) per word
+    const size_t MIN_RECENT_TERMS = 1024;
+    const size_t RECENT_TERMS_RATIO = 8;
+}
+
+
+// ------------------------------- Constructors ------------------------------- //
+
+TermDictionary::TermDictionary(std::pmr::memory_resource* resource)
+    : term_ids_(resource)
+    , recent_terms_(resource)
+{
+}
+
+
+// ------------------------------- Interaction with the class (public) ------------------------------- //
+
+std::string_view TermDictionary::Intern(std::string_view word)
+{
+    return Intern(word, HashTerm(word));
+}
+
+std::string_view TermDictionary::Intern(std::string_view word, size_t hash)
+{
+    const auto it = term_ids_.find(word, hash);
+    if (it != term_ids_.end())
+    {
+        return it->first;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(terms_.size());
+    const std::string_view stored_word = terms_.emplace_back(word);
+    term_ids_.try_emplace(stored_word, hash).first->second = id;
+    recent_terms_.insert(stored_word);
+
+    if (recent_terms_.size() > std::max(MIN_RECENT_TERMS, sorted_ids_.size() / RECENT_TERMS_RATIO))
+    {
+        MergeRecentTerms();
+    }
+    return stored_word;
+}
+
+bool TermDictionary::Contains(std::string_view word) const
+{
+    return term_ids_.count(word) > 0;
+}
+
+std::optional<uint32_t> TermDictionary::FindId(std::string_view word) const
+{
+    const auto it = term_ids_.find(word);
+    if (it == term_ids_.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t TermDictionary::size() const
+{
+    return terms_.size();
+}
+
+size_t TermDictionary::GetMemoryUsage() const
+{
+    size_t bytes = terms_.size() * sizeof(std::string);
+    for (const std::string& term : terms_)
+    {
+        bytes += GetStringHeapBytes(term);
+    }
+    bytes += term_ids_.GetMemoryUsage();
+    bytes += sorted_ids_.capacity() * sizeof(uint32_t);
+    bytes += recent_terms_.size() * (MAP_NODE_OVERHEAD + sizeof(std::string_view));
+    return bytes;
+}
+
+
+// ------------------------------- Cursor ------------------------------- //
+
+TermDictionary::Cursor::Cursor(const TermDictionary& dictionary)
+    : dictionary_(&dictionary)
+    , sorted_it_(dictionary.sorted_ids_.begin())
+    , recent_it_(dictionary.recent_terms_.begin())
+{
+    Settle();
+}
+
+bool TermDictionary::Cursor::IsValid() const
+{
+    return sorted_it_ != dictionary_->sorted_ids_.end() || recent_it_ != dictionary_->recent_terms_.end();
+}
+
+std::string_view TermDictionary::Cursor::GetWord() const
+{
+    return is_sorted_current_ ? std::string_view(dictionary_->terms_[*sorted_it_]) : *recent_it_;
+}
+
+void TermDictionary::Cursor::Next()
+{
+    if (is_sorted_current_)
+    {
+        ++sorted_it_;
+    }
+    else
+    {
+        ++recent_it_;
+    }
+    Settle();
+}
+
+void TermDictionary::Cursor::Seek(std::string_view word)
+{
+    const auto& terms = dictionary_->terms_;
+    const auto less = [&terms](uint32_t id, std::string_view value)
+    {
+        return std::string_view(terms[id]) < value;
+    };
+
+    // Seeks are mostly short jumps forward, so gallop from the current position
+    auto first = dictionary_->sorted_ids_.begin();
+    auto last = dictionary_->sorted_ids_.end();
+    if (sorted_it_ != last && less(*sorted_it_, word))
+    {
+        first = sorted_it_;
+        size_t step = 1;
+        while (step < static_cast<size_t>(last - first) && less(first[step], word))
+        {
+            first += step;
+            step *= 2;
+        }
+        last = first + std::min(step, static_cast<size_t>(last - first));
+    }
+    sorted_it_ = std::lower_bound(first, last, word, less);
+    recent_it_ = dictionary_->recent_terms_.lower_bound(word);
+    Settle();
+}
+
+void TermDictionary::Cursor::Settle()
+{
+    const bool has_sorted = sorted_it_ != dictionary_->sorted_ids_.end();
+    const bool has_recent = recent_it_ != dictionary_->recent_terms_.end();
+    is_sorted_current_ = has_sorted 
+        && (!has_recent || std::string_view(dictionary_->terms_[*sorted_it_]) < *recent_it_);
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+void TermDictionary::MergeRecentTerms()
+{
+    std::vector<uint32_t> recent_ids;
+    recent_ids.reserve(recent_terms_.size());
+    for (const std::string_view word : recent_terms_)
+    {
+        recent_ids.push_back(term_ids_.at(word));
+    }
+
+    std::vector<uint32_t> merged;
+    merged.reserve(sorted_ids_.size() + recent_ids.size());
+    std::merge(sorted_ids_.begin(), sorted_ids_.end(), recent_ids.begin(), recent_ids.end(),
+        std::back_inserter(merged),
+        [this](uint32_t lhs, uint32_t rhs)
+        {
+            return terms_[lhs] < terms_[rhs];
+        });
+
+    sorted_ids_ = std::move(merged);
+    recent_terms_.clear();
+}
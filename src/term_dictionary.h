@@ -0,0 +1,111 @@
+#pragma once
+
+// TermDictionary - owns strings of all words of the indexed documents
+// Every word is stored once and gets an id, the index structures keep string_view to the stored words,
+// so they stay valid after removing the document the word came from
+// Words are also kept sorted for prefix search: a compact sorted array of ids
+// plus a small sorted set of recently added words, which is merged into the array from time to time
+
+#include "term_hash_map.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TermDictionary
+{
+public:
+    // Nodes of the lookup structures are allocated from resource
+    explicit TermDictionary(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Add the word if it is not in the dictionary yet
+    // Return the word stored in the dictionary
+    std::string_view Intern(std::string_view word);
+
+    // Same with the hash of the word computed by HashTerm
+    std::string_view Intern(std::string_view word, size_t hash);
+
+    // Check if the word is in the dictionary
+    bool Contains(std::string_view word) const;
+
+    // Id of the word, ids are given in the order of adding from 0
+    std::optional<uint32_t> FindId(std::string_view word) const;
+
+    // Word stored in the dictionary by its id
+    std::string_view GetWord(uint32_t id) const
+    {
+        return terms_[id];
+    }
+
+    // Amount of words in the dictionary
+    size_t size() const;
+
+    // Estimated bytes of the strings and indexes of the dictionary
+    size_t GetMemoryUsage() const;
+
+    // Cursor over words of the dictionary in lexicographical order
+    // Merges the sorted array and the set of recently added words
+    // Invalidated by adding words to the dictionary
+    class Cursor
+    {
+    public:
+        // Cursor at the first word of the dictionary
+        explicit Cursor(const TermDictionary& dictionary);
+
+        bool IsValid() const;
+        std::string_view GetWord() const;
+
+        // Move to the next word
+        void Next();
+
+        // Move to the first word not less than word
+        void Seek(std::string_view word);
+
+    private:
+        // Choose the smallest of the current words of both sources
+        void Settle();
+
+        const TermDictionary* dictionary_;
+        std::vector<uint32_t>::const_iterator sorted_it_;
+        std::pmr::set<std::string_view>::const_iterator recent_it_;
+        bool is_sorted_current_ = false;
+    };
+
+    // Call callback for words starting with prefix in lexicographical order
+    // Callback returns false to stop the enumeration
+    template <typename Callback>
+    void ForEachWithPrefix(std::string_view prefix, Callback callback) const
+    {
+        Cursor cursor(*this);
+        for (cursor.Seek(prefix); cursor.IsValid(); cursor.Next())
+        {
+            const std::string_view word = cursor.GetWord();
+            if (word.substr(0, prefix.size()) != prefix || !callback(word))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    // Merge recently added words into the sorted array
+    void MergeRecentTerms();
+
+    // Strings of the words, index is id of the word. Deque doesn't move elements on push_back
+    std::deque<std::string> terms_;
+
+    // Word -> id
+    TermHashMap<uint32_t> term_ids_;
+
+    // Ids of words sorted by the words
+    std::vector<uint32_t> sorted_ids_;
+
+    // Words added after the last merge
+    std::pmr::set<std::string_view> recent_terms_;
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+// TermFreqColumn - term frequencies of a posting list stored with the precision chosen for the index
+// DOUBLE keeps the exact value (8 bytes), FLOAT - 4 bytes with about 7 significant digits,
+// UINT8 - 1 byte: a quantized impact code * per-term scale, the scale is at least the largest frequency of the term / 255.
+// When a larger frequency comes, codes are rescaled to a scale at least twice larger: every rescale adds half a step of error,
+// and the halves of the growing steps sum to less than one step of the final scale.
+// Scoring reads frequencies by blocks with Decode (or TermFreqBlockReader for merged lists): a loop over one narrow type,
+// which the compiler vectorizes. Sparse reads go through Visit, so the precision is checked once per list, not per posting
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TermFreqPrecision
+{
+    DOUBLE,
+    FLOAT,
+    UINT8,
+};
+
+class TermFreqColumn
+{
+public:
+    static constexpr double MAX_CODE = 255.0;
+
+    explicit TermFreqColumn(TermFreqPrecision precision = TermFreqPrecision::DOUBLE)
+        : precision_(precision)
+    {
+    }
+
+    TermFreqPrecision GetPrecision() const
+    {
+        return precision_;
+    }
+
+    size_t size() const
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            return floats_.size();
+        case TermFreqPrecision::UINT8:
+            return codes_.size();
+        default:
+            return doubles_.size();
+        }
+    }
+
+    double operator[](size_t index) const
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            return floats_[index];
+        case TermFreqPrecision::UINT8:
+            return codes_[index] * scale_;
+        default:
+            return doubles_[index];
+        }
+    }
+
+    void push_back(double term_freq)
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            floats_.push_back(static_cast<float>(term_freq));
+            break;
+        case TermFreqPrecision::UINT8:
+            if (term_freq > scale_ * MAX_CODE)
+            {
+                Rescale(std::max(term_freq / MAX_CODE, 2.0 * scale_));
+            }
+            codes_.push_back(Quantize(term_freq / scale_));
+            break;
+        default:
+            doubles_.push_back(term_freq);
+            break;
+        }
+    }
+
+    void erase(size_t index)
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            floats_.erase(floats_.begin() + index);
+            break;
+        case TermFreqPrecision::UINT8:
+            codes_.erase(codes_.begin() + index);
+            break;
+        default:
+            doubles_.erase(doubles_.begin() + index);
+            break;
+        }
+    }
+
+    // Remove frequencies at the indexes for which is_removed(index) is true, in one pass keeping the order
+    template <typename Predicate>
+    void RemoveIf(Predicate is_removed)
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            RemoveIf(floats_, is_removed);
+            break;
+        case TermFreqPrecision::UINT8:
+            RemoveIf(codes_, is_removed);
+            break;
+        default:
+            RemoveIf(doubles_, is_removed);
+            break;
+        }
+    }
+
+    // Write frequencies [first, last) to out
+    void Decode(size_t first, size_t last, double* out) const
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            std::copy(floats_.begin() + first, floats_.begin() + last, out);
+            break;
+        case TermFreqPrecision::UINT8:
+        {
+            const uint8_t* codes = codes_.data() + first;
+            const double scale = scale_;
+            for (size_t i = 0; i < last - first; ++i)
+            {
+                out[i] = codes[i] * scale;
+            }
+            break;
+        }
+        default:
+            std::copy(doubles_.begin() + first, doubles_.begin() + last, out);
+            break;
+        }
+    }
+
+    // Call function(read) once with read(index) returning the frequency at the index from the stored type
+    template <typename Function>
+    void Visit(Function function) const
+    {
+        switch (precision_)
+        {
+        case TermFreqPrecision::FLOAT:
+            function([values = floats_.data()](size_t index) { return static_cast<double>(values[index]); });
+            break;
+        case TermFreqPrecision::UINT8:
+            function([codes = codes_.data(), scale = scale_](size_t index) { return codes[index] * scale; });
+            break;
+        default:
+            function([values = doubles_.data()](size_t index) { return values[index]; });
+            break;
+        }
+    }
+
+    // Upper bound of the error of a decoded frequency of UINT8 (0 for other precisions)
+    double GetQuantizationStep() const
+    {
+        return precision_ == TermFreqPrecision::UINT8 ? scale_ : 0.0;
+    }
+
+    size_t GetMemoryUsage() const
+    {
+        return doubles_.capacity() * sizeof(double) + floats_.capacity() * sizeof(float) + codes_.capacity() * sizeof(uint8_t);
+    }
+
+private:
+    // Frequencies of words in documents are positive, so the smallest code is 1
+    static uint8_t Quantize(double value)
+    {
+        return static_cast<uint8_t>(std::clamp(std::lround(value), 1l, static_cast<long>(MAX_CODE)));
+    }
+
+    template <typename Value, typename Predicate>
+    static void RemoveIf(std::vector<Value>& values, Predicate& is_removed)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (!is_removed(i))
+            {
+                values[kept++] = values[i];
+            }
+        }
+        values.resize(kept);
+    }
+
+    void Rescale(double scale)
+    {
+        for (uint8_t& code : codes_)
+        {
+            code = Quantize(code * scale_ / scale);
+        }
+        scale_ = scale;
+    }
+
+    TermFreqPrecision precision_;
+    std::vector<double> doubles_;
+    std::vector<float> floats_;
+    std::vector<uint8_t> codes_;
+    double scale_ = 0.0;
+};
+
+// Reader of frequencies [first, last) of a column by increasing indexes, decoded by blocks of BLOCK_SIZE
+class TermFreqBlockReader
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    TermFreqBlockReader(const TermFreqColumn& column, size_t last)
+        : column_(&column)
+        , last_(last)
+    {
+    }
+
+    // The index is in [first, last) and not less than the previous one
+    double operator[](size_t index)
+    {
+        if (index >= block_end_)
+        {
+            block_first_ = index;
+            block_end_ = std::min(last_, index + BLOCK_SIZE);
+            column_->Decode(block_first_, block_end_, block_.data());
+        }
+        return block_[index - block_first_];
+    }
+
+private:
+    const TermFreqColumn* column_;
+    size_t last_;
+    size_t block_first_ = 0;
+    size_t block_end_ = 0;
+    std::array<double, BLOCK_SIZE> block_ = {};
+};
@@ -0,0 +1,402 @@
+#pragma once
+
+// TermHashMap - flat open-addressing hash table keyed by words (SwissTable-style)
+// Every slot has a control byte: 7 bits of the hash of its key, or EMPTY / DELETED.
+// Slots are probed by groups of 16 control bytes, which are compared with the hash at once (SSE2 when it is available),
+// so a lookup usually checks one group and compares one key.
+// Values are kept apart from the table in a deque, so their addresses are stable while they are in the map:
+// the table only stores indexes of values and can be rebuilt without moving them.
+// Keys are not owned, the words must outlive the map (the server keeps them in the term dictionary).
+// Hash of a word can be computed once by HashTerm and passed to the lookups.
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+inline size_t HashTerm(std::string_view word)
+{
+    return std::hash<std::string_view>()(word);
+}
+
+template <typename Value>
+class TermHashMap
+{
+public:
+    using value_type = std::pair<const std::string_view, Value>;
+
+private:
+    using Entries = std::pmr::deque<std::optional<value_type>>;
+
+    // Iterates over the values in the order of insertion (places of erased values are reused)
+    template <typename EntriesPointer, typename Reference>
+    class BasicIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TermHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::remove_reference_t<Reference>*;
+        using reference = Reference;
+
+        BasicIterator() = default;
+
+        BasicIterator(EntriesPointer entries, size_t index)
+            : entries_(entries)
+            , index_(index)
+        {
+            SkipErased();
+        }
+
+        // Mutable iterator converts to the constant one
+        template <typename OtherPointer, typename OtherReference>
+        BasicIterator(const BasicIterator<OtherPointer, OtherReference>& other)
+            : entries_(other.entries_)
+            , index_(other.index_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return *(*entries_)[index_];
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        BasicIterator& operator++()
+        {
+            ++index_;
+            SkipErased();
+            return *this;
+        }
+
+        BasicIterator operator++(int)
+        {
+            BasicIterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const BasicIterator& other) const
+        {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const BasicIterator& other) const
+        {
+            return index_ != other.index_;
+        }
+
+    private:
+        template <typename, typename>
+        friend class BasicIterator;
+        friend class TermHashMap;
+
+        void SkipErased()
+        {
+            while (index_ < entries_->size() && !(*entries_)[index_])
+            {
+                ++index_;
+            }
+        }
+
+        EntriesPointer entries_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using iterator = BasicIterator<Entries*, value_type&>;
+    using const_iterator = BasicIterator<const Entries*, const value_type&>;
+
+    explicit TermHashMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : control_(resource)
+        , slots_(resource)
+        , entries_(resource)
+        , free_entries_(resource)
+    {
+    }
+
+    iterator begin()
+    {
+        return iterator(&entries_, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(&entries_, entries_.size());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(&entries_, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(&entries_, entries_.size());
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    iterator find(std::string_view key)
+    {
+        return find(key, HashTerm(key));
+    }
+
+    iterator find(std::string_view key, size_t hash)
+    {
+        const size_t slot = FindSlot(key, hash);
+        return slot == NPOS ? end() : iterator(&entries_, slots_[slot]);
+    }
+
+    const_iterator find(std::string_view key) const
+    {
+        return find(key, HashTerm(key));
+    }
+
+    const_iterator find(std::string_view key, size_t hash) const
+    {
+        const size_t slot = FindSlot(key, hash);
+        return slot == NPOS ? end() : const_iterator(&entries_, slots_[slot]);
+    }
+
+    size_t count(std::string_view key) const
+    {
+        return FindSlot(key, HashTerm(key)) == NPOS ? 0 : 1;
+    }
+
+    Value& at(std::string_view key)
+    {
+        const auto it = find(key);
+        if (it == end())
+        {
+            throw std::out_of_range("Error! Word is not in the map!");
+        }
+        return it->second;
+    }
+
+    const Value& at(std::string_view key) const
+    {
+        const auto it = find(key);
+        if (it == end())
+        {
+            throw std::out_of_range("Error! Word is not in the map!");
+        }
+        return it->second;
+    }
+
+    Value& operator[](std::string_view key)
+    {
+        return try_emplace(key, HashTerm(key)).first->second;
+    }
+
+    // Insert a default value if the key is not in the map
+    // Return the value of the key and whether it was inserted
+    std::pair<iterator, bool> try_emplace(std::string_view key, size_t hash)
+    {
+        const size_t found_slot = FindSlot(key, hash);
+        if (found_slot != NPOS)
+        {
+            return {iterator(&entries_, slots_[found_slot]), false};
+        }
+
+        // Deleted slots are counted as used, so there is always an empty slot to stop a probe
+        if ((size_ + deleted_ + 1) * MAX_LOAD_DENOMINATOR > control_.size() * MAX_LOAD_NUMERATOR)
+        {
+            Rehash();
+        }
+
+        size_t index = entries_.size();
+        if (free_entries_.empty())
+        {
+            entries_.emplace_back(std::in_place, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        }
+        else
+        {
+            index = free_entries_.back();
+            free_entries_.pop_back();
+            entries_[index].emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        }
+        InsertSlot(hash, static_cast<uint32_t>(index));
+        ++size_;
+        return {iterator(&entries_, index), true};
+    }
+
+    void erase(const_iterator it)
+    {
+        const std::string_view key = it->first;
+        const size_t slot = FindSlot(key, HashTerm(key));
+        control_[slot] = DELETED;
+        ++deleted_;
+        --size_;
+        entries_[it.index_].reset();
+        free_entries_.push_back(static_cast<uint32_t>(it.index_));
+    }
+
+    // Bytes of the table and of the storage of values (without memory owned by the values)
+    size_t GetMemoryUsage() const
+    {
+        return control_.capacity() * sizeof(int8_t) + slots_.capacity() * sizeof(uint32_t)
+            + entries_.size() * sizeof(typename Entries::value_type) + free_entries_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static const size_t GROUP_SIZE = 16;
+    static const size_t NPOS = static_cast<size_t>(-1);
+
+    // Control bytes of free slots, full slots keep 7 bits of the hash (0..127)
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    // Maximal share of used slots: 7/8
+    static const size_t MAX_LOAD_NUMERATOR = 7;
+    static const size_t MAX_LOAD_DENOMINATOR = 8;
+
+    // Higher bits of the hash choose the group, lower 7 bits are stored in the control byte
+    static size_t GetGroupHash(size_t hash)
+    {
+        return hash >> 7;
+    }
+
+    static int8_t GetControlHash(size_t hash)
+    {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    // Bit k is set if control byte k of the group is equal to value
+    static uint32_t MatchByte(const int8_t* group, int8_t value)
+    {
+#ifdef __SSE2__
+        const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            mask |= static_cast<uint32_t>(group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Bit k is set if slot k of the group is empty or deleted (control bytes with the sign bit)
+    static uint32_t MatchFree(const int8_t* group)
+    {
+#ifdef __SSE2__
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static size_t LowestBit(uint32_t mask)
+    {
+        return static_cast<size_t>(__builtin_ctz(mask));
+    }
+
+    // Groups are probed triangularly: g, g + 1, g + 3, g + 6, ... visits every group of a power of two
+    size_t FindSlot(std::string_view key, size_t hash) const
+    {
+        if (control_.empty())
+        {
+            return NPOS;
+        }
+        const size_t group_mask = control_.size() / GROUP_SIZE - 1;
+        const int8_t control_hash = GetControlHash(hash);
+        size_t group = GetGroupHash(hash) & group_mask;
+        for (size_t step = 1; ; ++step)
+        {
+            const int8_t* group_control = control_.data() + group * GROUP_SIZE;
+            for (uint32_t mask = MatchByte(group_control, control_hash); mask != 0; mask &= mask - 1)
+            {
+                const size_t slot = group * GROUP_SIZE + LowestBit(mask);
+                if (entries_[slots_[slot]]->first == key)
+                {
+                    return slot;
+                }
+            }
+            if (MatchByte(group_control, EMPTY) != 0)
+            {
+                return NPOS;
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    void InsertSlot(size_t hash, uint32_t index)
+    {
+        const size_t group_mask = control_.size() / GROUP_SIZE - 1;
+        size_t group = GetGroupHash(hash) & group_mask;
+        for (size_t step = 1; ; ++step)
+        {
+            const uint32_t mask = MatchFree(control_.data() + group * GROUP_SIZE);
+            if (mask != 0)
+            {
+                const size_t slot = group * GROUP_SIZE + LowestBit(mask);
+                if (control_[slot] == DELETED)
+                {
+                    --deleted_;
+                }
+                control_[slot] = GetControlHash(hash);
+                slots_[slot] = index;
+                return;
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // Rebuild the table for twice the values, dropping deleted slots
+    void Rehash()
+    {
+        size_t capacity = GROUP_SIZE;
+        while (capacity * MAX_LOAD_NUMERATOR < (size_ + 1) * 2 * MAX_LOAD_DENOMINATOR)
+        {
+            capacity *= 2;
+        }
+        control_.assign(capacity, EMPTY);
+        slots_.assign(capacity, 0);
+        deleted_ = 0;
+        for (size_t index = 0; index < entries_.size(); ++index)
+        {
+            if (entries_[index])
+            {
+                InsertSlot(HashTerm(entries_[index]->first), static_cast<uint32_t>(index));
+            }
+        }
+    }
+
+    std::pmr::vector<int8_t> control_;
+    std::pmr::vector<uint32_t> slots_;      // index of the value of every full slot
+    Entries entries_;
+    std::pmr::vector<uint32_t> free_entries_;   // places of erased values
+    size_t size_ = 0;
+    size_t deleted_ = 0;
+};
@@ -1,16 +1,32 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <ctime>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 #include <iostream>
+#include <thread>
 #include <tuple>
 
 #include "search_server.h"     // Класс поисковой системы для тестирования
+#include "index_memory_resource.h"
+#include "paginator.h"
+#include "process_queries.h"
+#include "request_queue.h"
+#include "segmented_search_server.h"
+#include "term_hash_map.h"
 
 namespace Test_SearchServer
 {
@@ -331,6 +347,1605 @@ namespace Test_SearchServer
         }
     }
 
+    // Тест на поиск по фразам в кавычках
+    void TestPhraseQueries()
+    {
+        SearchServer server("the");
+        server.AddDocument(1, "high availability of the cluster", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "availability is high", DocumentStatus::ACTUAL, {2});
+        server.AddDocument(3, "high the availability", DocumentStatus::ACTUAL, {3});
+
+        // Документ находится, только если слова фразы стоят подряд
+        {
+            const auto found_docs = server.FindTopDocuments("\"high availability\"");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 1);
+        }
+
+        // Стоп-слова сохраняют свое место во фразе
+        {
+            const auto found_docs = server.FindTopDocuments("\"high the availability\"");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 3);
+        }
+
+        // Слова фразы возвращаются при матчинге только для документов с фразой
+        {
+            const auto [words, status] = server.MatchDocument("\"high availability\"", 2);
+            ASSERT(words.empty());
+            const auto [words1, status1] = server.MatchDocument("\"high availability\" cluster", 1);
+            ASSERT_EQUAL(words1.size(), 3u);
+        }
+
+        // Без позиционного индекса фразы недоступны
+        {
+            SearchServerOptions options;
+            options.use_positional_index = false;
+            SearchServer server_without_positions("the", options);
+            server_without_positions.AddDocument(1, "high availability", DocumentStatus::ACTUAL, {1});
+            ASSERT_EQUAL(server_without_positions.GetPositionalIndexMemoryUsage().position_count, 0u);
+            try
+            {
+                server_without_positions.FindTopDocuments("\"high availability\"");
+                ASSERT_HINT(false, "Phrase query without positional index must throw");
+            }
+            catch (const std::invalid_argument&)
+            {
+            }
+        }
+        ASSERT_EQUAL(server.GetPositionalIndexMemoryUsage().position_count, 9u);
+    }
+
+    // Тест на поиск по префиксам слов
+    void TestPrefixQueries()
+    {
+        SearchServer server("");
+        server.AddDocument(1, "server service cat", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "servant dog", DocumentStatus::ACTUAL, {2});
+        server.AddDocument(3, "dog cat", DocumentStatus::ACTUAL, {3});
+
+        // Префикс находит документы со всеми словами, начинающимися с него
+        {
+            const auto found_docs = server.FindTopDocuments("serv*");
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT_EQUAL(found_docs[0].id, 1);
+            ASSERT_EQUAL(found_docs[1].id, 2);
+        }
+
+        // Минус-префикс исключает документы
+        {
+            const auto found_docs = server.FindTopDocuments("cat -serv*");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 3);
+        }
+
+        // Количество слов, найденных по префиксу, ограничено
+        {
+            SearchServerOptions options;
+            options.max_prefix_expansions = 1;
+            SearchServer limited_server("", options);
+            limited_server.AddDocument(1, "server", DocumentStatus::ACTUAL, {1});
+            limited_server.AddDocument(2, "servant", DocumentStatus::ACTUAL, {2});
+            const auto found_docs = limited_server.FindTopDocuments("serv*");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+        }
+
+        // Ограничение не действует на минус-префиксы: исключаются документы со всеми найденными словами
+        {
+            SearchServerOptions options;
+            options.max_prefix_expansions = 2;
+            SearchServer limited_server("", options);
+            limited_server.AddDocument(1, "cat serva", DocumentStatus::ACTUAL, {1});
+            limited_server.AddDocument(2, "cat servb", DocumentStatus::ACTUAL, {2});
+            limited_server.AddDocument(3, "cat servc", DocumentStatus::ACTUAL, {3});
+            limited_server.AddDocument(4, "cat dog", DocumentStatus::ACTUAL, {4});
+            const auto found_docs = limited_server.FindTopDocuments("cat -serv*");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 4);
+            ASSERT(std::get<0>(limited_server.MatchDocument("cat -serv*", 3)).empty());
+        }
+
+        // Слова удаленного документа не находятся по префиксу
+        {
+            server.RemoveDocument(1);
+            const auto found_docs = server.FindTopDocuments("serv*");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+        }
+    }
+
+    // Тест на нечеткий поиск слов с опечатками
+    void TestFuzzyQueries()
+    {
+        SearchServer server("");
+        server.AddDocument(1, "server cat", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "servers dog", DocumentStatus::ACTUAL, {2});
+
+        // Без нечеткого поиска слово с опечаткой не находится
+        ASSERT(server.FindTopDocuments("sevrer").empty());
+
+        // Перестановка букв - это две замены
+        {
+            ASSERT(server.FindTopDocuments("sevrer~").empty());
+            const auto found_docs = server.FindTopDocuments("sevrer~2");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 1);
+        }
+
+        // Более близкие слова получают больший вес
+        {
+            const auto found_docs = server.FindTopDocuments("servers~");
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+            ASSERT_EQUAL(found_docs[1].id, 1);
+        }
+
+        // Нечеткие минус-слова исключают документы
+        {
+            const auto found_docs = server.FindTopDocuments("cat dog -sevrer~2");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+        }
+
+        // Ограничение количества слов не действует на нечеткие минус-слова
+        {
+            SearchServerOptions options;
+            options.max_fuzzy_expansions = 2;
+            SearchServer limited_server("", options);
+            limited_server.AddDocument(1, "cat cart", DocumentStatus::ACTUAL, {1});
+            limited_server.AddDocument(2, "cat card", DocumentStatus::ACTUAL, {2});
+            limited_server.AddDocument(3, "cat care", DocumentStatus::ACTUAL, {3});
+            limited_server.AddDocument(4, "cat dog", DocumentStatus::ACTUAL, {4});
+            const auto found_docs = limited_server.FindTopDocuments("cat -carx~");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 4);
+        }
+    }
+
+    // Тест на выбор функции ранжирования
+    void TestScoringPolicies()
+    {
+        SearchServer server("");
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat cat cat dog bird fish mouse owl", DocumentStatus::ACTUAL, {2});
+        server.AddDocument(3, "bird", DocumentStatus::ACTUAL, {3});
+
+        // TF-IDF используется по умолчанию
+        {
+            const auto found_docs = server.FindTopDocuments("cat");
+            const auto tf_idf_docs = server.FindTopDocuments<TfIdfScorer>("cat");
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT_EQUAL(tf_idf_docs.size(), 2u);
+            ASSERT(fequal(found_docs[0].relevance, tf_idf_docs[0].relevance));
+            ASSERT_EQUAL(found_docs[0].id, 1);
+        }
+
+        // BM25 учитывает количество вхождений слова, а не только его долю в документе
+        {
+            const auto found_docs = server.FindTopDocuments<Bm25Scorer>(std::execution::par, "cat");
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+            const double idf = std::log(1.0 + (3 - 2 + 0.5) / (2 + 0.5));
+            const double average_length = 11.0 / 3.0;
+            const double expected = idf * 3 * 2.2 / (3 + 1.2 * (0.25 + 0.75 * 8 / average_length));
+            ASSERT(fequal(found_docs[0].relevance, expected));
+        }
+    }
+
+    // Тест на фильтр по статусу и диапазону рейтинга
+    void TestDocumentFilter()
+    {
+        SearchServer server("");
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat bird", DocumentStatus::ACTUAL, {5});
+        server.AddDocument(3, "cat fish", DocumentStatus::BANNED, {5});
+        server.AddDocument(4, "cat mouse", DocumentStatus::ACTUAL, {9});
+        server.RemoveDocument(2);
+        server.AddDocument(5, "cat owl", DocumentStatus::ACTUAL, {6});
+
+        DocumentFilter filter;
+        filter.status = DocumentStatus::ACTUAL;
+        filter.min_rating = 2;
+        filter.max_rating = 8;
+        {
+            const auto found_docs = server.FindTopDocuments("cat", filter);
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 5);
+            ASSERT_EQUAL(found_docs[0].rating, 6);
+        }
+
+        // Без статуса проверяется только рейтинг
+        filter.status.reset();
+        {
+            const auto found_docs = server.FindTopDocuments(std::execution::par, "cat", filter);
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT(std::get<1>(server.MatchDocument("cat", 3)) == DocumentStatus::BANNED);
+        }
+    }
+
+    // Тест на сжатые множества документов с минус-словами
+    void TestRoaringBitmap()
+    {
+        // Разреженный блок (массив), плотный блок (битсет) и диапазон (серии)
+        std::vector<uint32_t> sparse, dense, range;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            sparse.push_back(i * 7);
+        }
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            dense.push_back((1u << 16) + i * 3);
+        }
+        for (uint32_t i = 0; i < 50000; ++i)
+        {
+            range.push_back((2u << 16) + i);
+        }
+
+        RoaringBitmap bitmap = RoaringBitmap::FromSorted(sparse);
+        bitmap |= RoaringBitmap::FromSorted(dense);
+        bitmap |= RoaringBitmap::FromSorted(range);
+        bitmap |= RoaringBitmap::FromSorted(sparse);
+        ASSERT_EQUAL(bitmap.GetCardinality(), sparse.size() + dense.size() + range.size());
+        for (const auto* values : {&sparse, &dense, &range})
+        {
+            for (const uint32_t value : *values)
+            {
+                ASSERT(bitmap.Contains(value));
+            }
+        }
+        ASSERT(!bitmap.Contains(1));
+        ASSERT(!bitmap.Contains((1u << 16) + 1));
+        ASSERT(!bitmap.Contains((2u << 16) + 50000));
+        ASSERT(!bitmap.Contains(3u << 16));
+        ASSERT(bitmap.GetMemoryUsage() < 20000);
+
+        // Документы с минус-словами не попадают в результат
+        SearchServer server("");
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat bird", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(3, "cat fish", DocumentStatus::ACTUAL, {1});
+        for (const auto& found_docs : {server.FindTopDocuments("cat serv* -dog -fish"),
+            server.FindTopDocuments(std::execution::par, "cat -dog -fish -owl")})
+        {
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 2);
+        }
+    }
+
+    // Тест на обязательные слова (+слово) и пересечение списков документов
+    void TestRequiredWords()
+    {
+        // Пересечение блоками и галопом совпадает с std::set_intersection
+        {
+            std::vector<uint32_t> lhs, rhs, sparse;
+            for (uint32_t i = 0; i < 10000; ++i)
+            {
+                if (i % 3 == 0) lhs.push_back(i);
+                if (i % 5 == 0 || i % 7 == 0) rhs.push_back(i);
+                if (i % 997 == 0) sparse.push_back(i);
+            }
+            std::vector<uint32_t> expected;
+            std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+            ASSERT(BlockIntersect(lhs, rhs) == expected);
+            ASSERT(IntersectPostings(rhs, lhs) == expected);
+
+            expected.clear();
+            std::set_intersection(lhs.begin(), lhs.end(), sparse.begin(), sparse.end(), std::back_inserter(expected));
+            ASSERT(GallopingIntersect(lhs, sparse) == expected);
+            ASSERT(IntersectPostings(sparse, lhs) == expected);
+        }
+
+        SearchServer server("and");
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat bird", DocumentStatus::ACTUAL, {2});
+        server.AddDocument(3, "cat dog bird", DocumentStatus::ACTUAL, {3});
+        server.AddDocument(4, "dog and bird", DocumentStatus::ACTUAL, {4});
+
+        // Найдены только документы со всеми обязательными словами, релевантность как у обычного запроса
+        {
+            const auto found_docs = server.FindTopDocuments("+cat +bird");
+            const auto any_docs = server.FindTopDocuments("cat bird");
+            ASSERT_EQUAL(found_docs.size(), 2u);
+            ASSERT_EQUAL(any_docs.size(), 4u);
+            for (const Document& document : found_docs)
+            {
+                ASSERT(document.id == 2 || document.id == 3);
+                const auto it = std::find_if(any_docs.begin(), any_docs.end(),
+                    [&document](const Document& any_document)
+                    {
+                        return any_document.id == document.id;
+                    });
+                ASSERT(fequal(it->relevance, document.relevance));
+            }
+        }
+
+        // Обязательные слова вместе с обычными, минус-словами и фразами
+        {
+            const auto found_docs = server.FindTopDocuments(std::execution::par, "+dog cat -bird");
+            ASSERT_EQUAL(found_docs.size(), 1u);
+            ASSERT_EQUAL(found_docs[0].id, 1);
+            ASSERT_EQUAL(server.FindTopDocuments("+dog \"dog bird\"").size(), 1u);
+            ASSERT_EQUAL(server.FindTopDocuments("+cat +owl").size(), 0u);
+        }
+
+        // Проверка в MatchDocument
+        {
+            ASSERT_EQUAL(std::get<0>(server.MatchDocument("+cat dog", 4)).size(), 0u);
+            ASSERT_EQUAL(std::get<0>(server.MatchDocument("+cat dog", 3)).size(), 2u);
+        }
+
+        // Некорректные обязательные слова
+        for (const std::string query : {"+", "cat +", "-+cat", "++cat", "+cat*", "+cat~"})
+        {
+            try
+            {
+                server.FindTopDocuments(query);
+                ASSERT_HINT(false, query);
+            }
+            catch (const std::invalid_argument&)
+            {
+            }
+        }
+    }
+
+    // Тест на постраничную выдачу результатов
+    void TestResultPages()
+    {
+        SearchServer server("");
+        for (int id = 0; id < 30; ++id)
+        {
+            std::string content = "cat";
+            for (int i = 0; i < id % 7; ++i)
+            {
+                content += " dog";
+            }
+            server.AddDocument(id, content, DocumentStatus::ACTUAL, {id});
+        }
+        server.AddDocument(30, "cat", DocumentStatus::BANNED, {100});
+
+        // Все документы в порядке релевантности
+        std::vector<Document> expected;
+        for (const Document& document : server.FindResults("cat dog"))
+        {
+            expected.push_back(document);
+        }
+        ASSERT_EQUAL(expected.size(), 30u);
+        ASSERT(std::is_sorted(expected.begin(), expected.end(), IsMoreRelevant));
+        ASSERT_EQUAL(server.FindTopDocuments("cat dog")[0].id, expected[0].id);
+
+        // Страницы по 7 документов (последняя неполная)
+        std::vector<Document> pages;
+        for (size_t offset = 0; offset < 35; offset += 7)
+        {
+            const auto page = server.FindTopDocumentsPage("cat dog", offset, 7);
+            ASSERT_EQUAL(page.size(), offset + 7 <= 30 ? 7u : 30u - offset);
+            pages.insert(pages.end(), page.begin(), page.end());
+        }
+        ASSERT_EQUAL(pages.size(), expected.size());
+        for (size_t i = 0; i < pages.size(); ++i)
+        {
+            ASSERT_EQUAL(pages[i].id, expected[i].id);
+        }
+
+        // Ленивая разбивка на страницы
+        {
+            const SearchResults results = server.FindResults("cat dog", DocumentStatus::ACTUAL);
+            const auto result_pages = Paginate(results, 4);
+            ASSERT_EQUAL(result_pages.size(), 8u);
+            ASSERT_EQUAL(result_pages.begin()->begin()->id, expected[0].id);
+        }
+
+        // Итераторы произвольного доступа работают со стандартными алгоритмами
+        {
+            const SearchResults results = server.FindResults("cat dog", DocumentStatus::ACTUAL);
+            SearchResults::Iterator it = results.begin();
+            ASSERT_EQUAL((it++)->id, expected[0].id);
+            ASSERT_EQUAL(it->id, expected[1].id);
+            ASSERT_EQUAL((it--)->id, expected[1].id);
+            ASSERT_EQUAL(it[3].id, expected[3].id);
+            ASSERT_EQUAL((2 + it)->id, expected[2].id);
+            ASSERT_EQUAL((results.end() - 1)->id, expected.back().id);
+            it += 5;
+            it -= 2;
+            ASSERT_EQUAL(it->id, expected[3].id);
+            ASSERT(results.begin() < it && it > results.begin() && it <= it && it >= results.begin());
+            ASSERT_EQUAL(std::distance(results.begin(), results.end()), static_cast<std::ptrdiff_t>(expected.size()));
+            const Document& middle = expected[expected.size() / 2];
+            const auto found = std::lower_bound(results.begin(), results.end(), middle, IsMoreRelevant);
+            ASSERT(!IsMoreRelevant(*found, middle) && !IsMoreRelevant(middle, *found));
+            ASSERT(std::is_sorted(results.begin(), results.end(), IsMoreRelevant));
+        }
+
+        // После изменения индекса результаты ищутся заново
+        const uint64_t version = server.GetIndexVersion();
+        server.AddDocument(31, "cat dog dog dog dog dog dog dog", DocumentStatus::ACTUAL, {1});
+        ASSERT(server.GetIndexVersion() != version);
+        ASSERT_EQUAL(server.FindTopDocumentsPage("cat dog", 0, 1)[0].id, 31);
+        ASSERT_EQUAL(server.FindTopDocumentsPage("cat dog", DocumentStatus::BANNED, 0, 5).size(), 1u);
+    }
+
+    // Тест на статистику запросов в скользящем окне
+    void TestRequestQueue()
+    {
+        using namespace std::chrono_literals;
+
+        SearchServer server("");
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        RequestQueue queue(server, 10s);
+        const auto now = RequestQueue::Clock::now();
+
+        // Запросы через поисковую систему
+        ASSERT_EQUAL(queue.AddFindRequest("cat").size(), 1u);
+        ASSERT_EQUAL(queue.AddFindRequest("bird").size(), 0u);
+        ASSERT_EQUAL(queue.GetTotalRequests(), 2);
+        ASSERT_EQUAL(queue.GetNoResultRequests(), 1);
+
+        // Запросы, добавленные из нескольких потоков
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&queue, now]()
+                {
+                    for (int j = 0; j < 1000; ++j)
+                    {
+                        queue.AddRequest(j % 4 != 0, std::chrono::microseconds(j), now + 2s);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 2s), 4002);
+        ASSERT_EQUAL(queue.GetNoResultRequests(now + 2s), 1001);
+
+        // Гистограмма задержек: задержка 0 мкс у 4 запросов, 90% запросов быстрее 1024 мкс
+        const auto histogram = queue.GetLatencyHistogram(now + 2s);
+        ASSERT(histogram[0] >= 4u);
+        ASSERT_EQUAL(queue.GetLatencyQuantile(0.9, now + 2s).count(), 1024);
+
+        // Старые запросы выходят из окна
+        queue.AddRequest(true, 1ms, now + 11s);
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 11s), 4001);
+        ASSERT_EQUAL(queue.GetNoResultRequests(now + 11s), 1000);
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 12s), 1);
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 30s), 0);
+        ASSERT(queue.GetLatencyHistogram(now + 30s) == RequestQueue::LatencyHistogram{});
+
+        // Запрос старше окна не учитывается, запрос из окна учитывается, даже если пришёл позже
+        queue.AddRequest(false, 1ms, now + 31s);
+        queue.AddRequest(false, 1ms, now + 5s);
+        queue.AddRequest(false, 1ms, now + 25s);
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 31s), 2);
+        ASSERT_EQUAL(queue.GetNoResultRequests(now + 31s), 2);
+        ASSERT_EQUAL(queue.GetLatencyQuantile(0.5, now + 31s).count(), 1024);
+        ASSERT_EQUAL(queue.GetTotalRequests(now + 36s), 1);
+    }
+
+    // Тест на метрики этапов запроса
+    void TestQueryMetrics()
+    {
+        // Границы корзин гистограммы
+        for (const uint64_t value : {0ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull})
+        {
+            const size_t index = LatencyHistogram::GetBucketIndex(value);
+            ASSERT(LatencyHistogram::GetBucketLowerBound(index) <= value);
+            ASSERT(value < LatencyHistogram::GetBucketUpperBound(index));
+            ASSERT(LatencyHistogram::GetBucketUpperBound(index) - LatencyHistogram::GetBucketLowerBound(index) <= value / 8 + 1);
+        }
+
+        // Без опции метрики не собираются
+        {
+            SearchServer server("");
+            server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+            server.FindTopDocuments("cat");
+            ASSERT_EQUAL(server.GetQueryMetrics().queries, 0u);
+        }
+
+        SearchServerOptions options;
+        options.collect_query_metrics = true;
+        SearchServer server("", options);
+        server.AddDocument(1, "cat dog", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat bird", DocumentStatus::ACTUAL, {1});
+        server.FindTopDocuments("cat -bird");
+        server.FindTopDocuments(std::execution::par, "cat dog");
+        server.FindTopDocumentsPage("cat", 0, 1);
+        server.FindTopDocumentsPage("cat", 1, 1);
+
+        const QueryMetricsSnapshot snapshot = server.GetQueryMetrics();
+        ASSERT_EQUAL(snapshot.queries, 2u);
+        ASSERT_EQUAL(snapshot.stage_durations[static_cast<size_t>(QueryStage::PARSE)].count, 2u);
+        ASSERT_EQUAL(snapshot.stage_durations[static_cast<size_t>(QueryStage::SCAN)].count, 3u);
+        ASSERT_EQUAL(snapshot.postings_scanned, 2u + 2u + 1u + 2u);
+        ASSERT_EQUAL(snapshot.candidates, 1u + 2u + 2u);
+        ASSERT_EQUAL(snapshot.page_cache_hits, 1u);
+        ASSERT_EQUAL(snapshot.page_cache_misses, 1u);
+
+        std::ostringstream out;
+        server.WriteQueryMetrics(out);
+        ASSERT(out.str().find("search_server_stage_duration_seconds_count{stage=\"parse\"} 2\n") != std::string::npos);
+        ASSERT(out.str().find("search_server_page_cache_hits_total 1\n") != std::string::npos);
+    }
+
+    // Тест на пул потоков и пакетную обработку запросов
+    void TestQueryBatch()
+    {
+        // Вложенные задачи: задача ждёт свои подзадачи, не блокируя пул
+        {
+            ThreadPool pool(2);
+            std::vector<int> sums(8, 0);
+            pool.ParallelFor(sums.size(), [&pool, &sums](size_t i)
+                {
+                    std::vector<int> parts(10, 0);
+                    pool.ParallelFor(parts.size(), [&parts, i](size_t j)
+                        {
+                            parts[j] = static_cast<int>(i * j);
+                        });
+                    sums[i] = std::accumulate(parts.begin(), parts.end(), 0);
+                });
+            for (size_t i = 0; i < sums.size(); ++i)
+            {
+                ASSERT_EQUAL(sums[i], static_cast<int>(i * 45));
+            }
+        }
+
+        // Поток вне пула ждёт долгую задачу, не занимая процессор
+        {
+            using namespace std::chrono_literals;
+            ThreadPool pool(1);
+            ThreadPool::TaskGroup group;
+            pool.Submit(group, []()
+                {
+                    std::this_thread::sleep_for(200ms);
+                });
+            timespec start{};
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+            pool.Wait(group);
+            timespec finish{};
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &finish);
+            ASSERT(group.IsDone());
+            const double cpu_seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) * 1e-9;
+            ASSERT_HINT(cpu_seconds < 0.05, "waiting thread must sleep");
+        }
+
+        // Исключение задачи не завершает процесс: Wait дожидается всех задач группы и бросает первое исключение
+        {
+            ThreadPool pool(2);
+            std::atomic<int> finished{0};
+            ThreadPool::TaskGroup group;
+            for (int i = 0; i < 10; ++i)
+            {
+                pool.Submit(group, [&finished, i]()
+                    {
+                        ++finished;
+                        if (i % 3 == 0)
+                        {
+                            throw std::runtime_error("task failed");
+                        }
+                    });
+            }
+            try
+            {
+                pool.Wait(group);
+                ASSERT_HINT(false, "exception of a task must be rethrown");
+            }
+            catch (const std::runtime_error& error)
+            {
+                ASSERT_EQUAL(std::string(error.what()), "task failed");
+            }
+            ASSERT(group.IsDone());
+            ASSERT_EQUAL(finished.load(), 10);
+
+            // Пул и группа работают дальше
+            pool.Submit(group, [&finished]()
+                {
+                    ++finished;
+                });
+            pool.Wait(group);
+            ASSERT_EQUAL(finished.load(), 11);
+        }
+
+        // Каждый запрос делится на подзадачи по диапазонам документов, результат совпадает с последовательным поиском
+        SearchServerOptions options;
+        options.query_threads = 3;
+        options.split_query_postings = 1;
+        SearchServer server("and", options);
+        const std::vector<std::string> words = {"cat", "dog", "bird", "fish", "cow", "owl"};
+        for (int id = 0; id < 200; ++id)
+        {
+            std::string text;
+            for (size_t i = 0; i < words.size(); ++i)
+            {
+                if ((id + 1) % (i + 2) == 0 || id % 7 == static_cast<int>(i))
+                {
+                    text += words[i] + " ";
+                }
+            }
+            server.AddDocument(id, text + "and", id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 11});
+        }
+        server.RemoveDocument(42);
+
+        const std::vector<std::string> queries = {
+            "cat dog", "+cat bird -fish", "\"cat dog\" owl", "ca* -cow", "owl~ fish", "+cow +owl", "horse", "+horse cat"
+        };
+        const auto results = server.FindTopDocumentsBatch(queries);
+        ASSERT_EQUAL(results.size(), queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const auto expected = server.FindTopDocuments(queries[i]);
+            ASSERT_EQUAL(results[i].size(), expected.size());
+            for (size_t j = 0; j < expected.size(); ++j)
+            {
+                ASSERT_EQUAL(results[i][j].id, expected[j].id);
+                ASSERT(fequal(results[i][j].relevance, expected[j].relevance));
+            }
+        }
+        ASSERT_EQUAL(ProcessQueriesJoined(server, queries).size(), 
+            std::accumulate(results.begin(), results.end(), size_t{0}, [](size_t size, const auto& documents)
+                {
+                    return size + documents.size();
+                }));
+        ASSERT_EQUAL(server.GetThreadPool().GetThreadCount(), 3u);
+    }
+
+    // Тест на асинхронные запросы с крайним сроком
+    void TestAsyncQueries()
+    {
+        using namespace std::chrono_literals;
+
+        SearchServerOptions options;
+        options.collect_query_metrics = true;
+        options.query_threads = 2;
+        SearchServer server("and", options);
+        for (int id = 0; id < 100; ++id)
+        {
+            server.AddDocument(id, id % 3 == 0 ? "cat dog" : "cat bird and owl", DocumentStatus::ACTUAL, {id});
+        }
+
+        // С далёким сроком результат полный и совпадает с синхронным поиском
+        {
+            std::future<TopDocumentsResult> result_future = server.FindTopDocumentsAsync("cat -dog owl", QueryDeadline::Clock::now() + 1h);
+            const TopDocumentsResult result = result_future.get();
+            const auto expected = server.FindTopDocuments("cat -dog owl");
+            ASSERT(!result.truncated);
+            ASSERT_EQUAL(result.documents.size(), expected.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_EQUAL(result.documents[i].id, expected[i].id);
+            }
+        }
+
+        // Истёкший срок и отменённый запрос: результат усечён, остановки учитываются в метриках
+        {
+            const TopDocumentsResult expired = server.FindTopDocumentsAsync("cat", QueryDeadline::Clock::now() - 1ms).get();
+            ASSERT(expired.truncated);
+            ASSERT(expired.documents.empty());
+
+            CancellationToken token;
+            token.Cancel();
+            DocumentFilter filter;
+            const TopDocumentsResult cancelled = server.FindTopDocumentsAsync("cat", filter, QueryDeadline::Clock::now() + 1h, token).get();
+            ASSERT(cancelled.truncated);
+
+            const QueryMetricsSnapshot snapshot = server.GetQueryMetrics();
+            ASSERT_EQUAL(snapshot.deadline_exceeded_queries, 1u);
+            ASSERT_EQUAL(snapshot.cancelled_queries, 1u);
+        }
+
+        // Ошибка в запросе передаётся через future
+        {
+            std::future<TopDocumentsResult> result_future = server.FindTopDocumentsAsync("cat --dog", QueryDeadline::Clock::now() + 1h);
+            bool is_thrown = false;
+            try
+            {
+                result_future.get();
+            }
+            catch (const std::invalid_argument&)
+            {
+                is_thrown = true;
+            }
+            ASSERT(is_thrown);
+        }
+    }
+
+    // Тест на упорядоченные по частоте списки и раннюю остановку
+    void TestImpactOrderedPostings()
+    {
+        // Списки упорядочены по убыванию частоты и разбиты на ярусы
+        {
+            PostingList postings;
+            postings.Append(0, 0.1);
+            postings.Append(1, 0.8);
+            postings.Append(2, 0.4);
+            postings.Append(3, 0.05);
+            postings.Append(4, 0.8);
+            const ImpactOrderedPostings impact = ImpactOrderedPostings::Build(postings);
+            ASSERT((impact.documents == std::vector<uint32_t>{1, 4, 2, 0, 3}));
+            ASSERT((impact.tier_ends == std::vector<size_t>{2, 3, 4, 5}));
+        }
+
+        // Результаты совпадают с полным просмотром списков
+        SearchServerOptions options;
+        options.collect_query_metrics = true;
+        options.impact_order_min_postings = 100;
+        SearchServer impact_server("and", options);
+        SearchServer server("and");
+        for (int id = 0; id < 1000; ++id)
+        {
+            std::string text = id % 211 == 0 ? "cat cat cat cat cat dog" : id % 2 == 0 ? "cat" : "";
+            text += id % 3 == 0 ? " dog dog" : " bird";
+            text += id % 89 == 0 ? " owl" : " and fish";
+            text += " filler" + std::to_string(id % 13) + " more" + std::to_string(id % 17);
+            const DocumentStatus status = id % 10 == 5 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+            impact_server.AddDocument(id, text, status, {id % 7});
+            server.AddDocument(id, text, status, {id % 7});
+        }
+        impact_server.RemoveDocument(97);
+        server.RemoveDocument(97);
+
+        // Порядок документов с равными релевантностью и рейтингом не определён, поэтому сравниваются они
+        const auto check = [](const std::vector<Document>& lhs, const std::vector<Document>& rhs)
+        {
+            ASSERT_EQUAL(lhs.size(), rhs.size());
+            for (size_t i = 0; i < lhs.size(); ++i)
+            {
+                ASSERT(fequal(lhs[i].relevance, rhs[i].relevance));
+                ASSERT_EQUAL(lhs[i].rating, rhs[i].rating);
+            }
+        };
+        for (const std::string query : {"cat", "cat dog", "cat -owl", "cat dog -bird", "cat +dog", "cat fish*", "owl"})
+        {
+            check(impact_server.FindTopDocuments(query), server.FindTopDocuments(query));
+            check(impact_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT), server.FindTopDocuments(query, DocumentStatus::IRRELEVANT));
+            const auto even = [](int document_id, DocumentStatus, int)
+            {
+                return document_id % 2 == 0;
+            };
+            check(impact_server.FindTopDocuments(query, even), server.FindTopDocuments(query, even));
+        }
+
+        // Документы с частым словом найдены без просмотра всего списка
+        const uint64_t scanned = impact_server.GetQueryMetrics().postings_scanned;
+        impact_server.FindTopDocuments("cat");
+        ASSERT(impact_server.GetQueryMetrics().postings_scanned - scanned < 100u);
+    }
+
+    // Тест на пакетный матчинг документов
+    void TestMatchDocuments()
+    {
+        SearchServer server("and");
+        server.AddDocument(1, "white cat and fancy collar", DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "fluffy cat fluffy tail", DocumentStatus::BANNED, {2});
+        server.AddDocument(3, "groomed dog expressive eyes", DocumentStatus::ACTUAL, {3});
+        server.AddDocument(4, "groomed cat with collar", DocumentStatus::ACTUAL, {4});
+
+        const std::vector<int> document_ids = {4, 1, 2, 3};
+        for (const std::string query : {"fluffy cat collar", "cat -tail", "+cat coll*", "+groomed dog~ eyes", "\"fancy collar\" cat", "owl"})
+        {
+            const MatchResults results = server.MatchDocuments(query, document_ids);
+            const MatchResults parallel_results = server.MatchDocuments(std::execution::par, query, document_ids);
+            ASSERT_EQUAL(results.size(), document_ids.size());
+            ASSERT(results.words == parallel_results.words);
+            ASSERT(results.word_ends == parallel_results.word_ends);
+            for (size_t i = 0; i < document_ids.size(); ++i)
+            {
+                // Совпадает с MatchDocument для одного документа
+                const auto [words, status] = server.MatchDocument(query, document_ids[i]);
+                const auto [parallel_words, parallel_status] = server.MatchDocument(std::execution::par, query, document_ids[i]);
+                const auto batch_words = results.GetWords(i);
+                ASSERT_EQUAL(results.document_ids[i], document_ids[i]);
+                ASSERT(results.statuses[i] == status);
+                ASSERT(parallel_status == status);
+                ASSERT(std::vector<std::string_view>(batch_words.begin(), batch_words.end()) == words);
+                ASSERT(parallel_words == words);
+                ASSERT(std::is_sorted(words.begin(), words.end()));
+            }
+        }
+
+        // Слова - ссылки на словарь, они не зависят от строки запроса
+        {
+            MatchResults results;
+            {
+                const std::string query = "collar cat -eyes";
+                results = server.MatchDocuments(query, {1, 3});
+            }
+            ASSERT_EQUAL(results.GetWords(0).size(), 2u);
+            ASSERT_EQUAL(*results.GetWords(0).begin(), "cat");
+            ASSERT_EQUAL(results.GetWords(1).size(), 0u);
+        }
+
+        // Неизвестный документ
+        {
+            bool is_thrown = false;
+            try
+            {
+                server.MatchDocuments(std::execution::par, "cat", {1, 5});
+            }
+            catch (const std::out_of_range&)
+            {
+                is_thrown = true;
+            }
+            ASSERT(is_thrown);
+        }
+    }
+
+    // Тест проверяет, что режимы прямого индекса дают одинаковые результаты и разный расход памяти
+    void TestForwardIndexModes()
+    {
+        const std::vector<std::string> texts = {
+            "white cat and fancy collar",
+            "fluffy cat fluffy tail",
+            "groomed dog expressive eyes",
+            "white dog and black cat",
+            "fluffy bird with white tail",
+        };
+        std::vector<std::unique_ptr<SearchServer>> servers;
+        for (const ForwardIndexMode mode : {ForwardIndexMode::FULL, ForwardIndexMode::COMPACT, ForwardIndexMode::NONE})
+        {
+            SearchServerOptions options;
+            options.forward_index = mode;
+            servers.push_back(std::make_unique<SearchServer>("and with", options));
+            for (size_t i = 0; i < texts.size(); ++i)
+            {
+                servers.back()->AddDocument(static_cast<int>(i) + 1, texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+            }
+        }
+        servers[0]->RemoveDocument(4);
+        servers[1]->RemoveDocument(std::execution::par, 4);
+        servers[2]->RemoveDocument(4);
+
+        const SearchServer& full = *servers[0];
+        for (size_t i = 1; i < servers.size(); ++i)
+        {
+            const SearchServer& server = *servers[i];
+            ASSERT_EQUAL(server.GetDocumentCount(), full.GetDocumentCount());
+            for (const int document_id : {1, 2, 3, 5})
+            {
+                ASSERT(server.GetWordFrequencies(document_id) == full.GetWordFrequencies(document_id));
+                for (const std::string query : {"fluffy white cat", "white -tail", "+white cat", "dog -eyes"})
+                {
+                    ASSERT(server.MatchDocument(query, document_id) == full.MatchDocument(query, document_id));
+                    ASSERT(server.MatchDocument(std::execution::par, query, document_id)
+                        == full.MatchDocument(std::execution::par, query, document_id));
+                }
+            }
+            ASSERT(server.GetWordFrequencies(4).empty());
+
+            const auto documents = server.FindTopDocuments("fluffy white cat");
+            const auto expected = full.FindTopDocuments("fluffy white cat");
+            ASSERT_EQUAL(documents.size(), expected.size());
+            for (size_t j = 0; j < documents.size(); ++j)
+            {
+                ASSERT_EQUAL(documents[j].id, expected[j].id);
+            }
+        }
+
+        // Компактный индекс меньше полного, без прямого индекса память на него не расходуется
+        const MemoryStats full_stats = servers[0]->GetMemoryStats();
+        const MemoryStats compact_stats = servers[1]->GetMemoryStats();
+        const MemoryStats none_stats = servers[2]->GetMemoryStats();
+        ASSERT(compact_stats.forward_index > 0);
+        ASSERT(compact_stats.forward_index < full_stats.forward_index);
+        ASSERT_EQUAL(none_stats.forward_index, 0u);
+        ASSERT(none_stats.dictionary > 0 && none_stats.postings > 0 && none_stats.content > 0 && none_stats.metadata > 0);
+        ASSERT_EQUAL(none_stats.postings, full_stats.postings);
+        ASSERT(none_stats.GetTotal() < full_stats.GetTotal());
+    }
+
+    // Тест проверяет, что узлы индекса выделяются из переданного ресурса памяти
+    void TestMemoryResource()
+    {
+        // Ресурс, считающий выделенные байты
+        class CountingResource : public std::pmr::memory_resource
+        {
+        public:
+            size_t allocated = 0;
+            size_t deallocated = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                allocated += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override
+            {
+                deallocated += bytes;
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+
+        const std::vector<std::string> texts = {
+            "white cat and fancy collar",
+            "fluffy cat fluffy tail",
+            "groomed dog expressive eyes",
+            "white dog and black cat",
+        };
+        SearchServer expected_server("and");
+        for (size_t i = 0; i < texts.size(); ++i)
+        {
+            expected_server.AddDocument(static_cast<int>(i) + 1, texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+        }
+
+        CountingResource counting;
+        {
+            IndexMemoryResource pool(&counting);
+            SearchServerOptions options;
+            options.memory_resource = &pool;
+            SearchServer server("and", options);
+            for (size_t i = 0; i < texts.size(); ++i)
+            {
+                server.AddDocument(static_cast<int>(i) + 1, texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+            }
+            ASSERT(counting.allocated > 0);
+
+            server.RemoveDocument(2);
+            expected_server.RemoveDocument(2);
+            for (const std::string query : {"fluffy white cat", "\"white cat\"", "dog -eyes", "+white cat"})
+            {
+                const auto documents = server.FindTopDocuments(query);
+                const auto expected = expected_server.FindTopDocuments(query);
+                ASSERT_EQUAL(documents.size(), expected.size());
+                for (size_t i = 0; i < documents.size(); ++i)
+                {
+                    ASSERT_EQUAL(documents[i].id, expected[i].id);
+                }
+            }
+            ASSERT(server.GetWordFrequencies(1) == expected_server.GetWordFrequencies(1));
+            ASSERT(std::vector<int>(server.begin(), server.end()) == std::vector<int>(expected_server.begin(), expected_server.end()));
+        }
+        // Пул возвращает всю память при разрушении
+        ASSERT_EQUAL(counting.deallocated, counting.allocated);
+
+        // Монотонный буфер подходит для индекса, который только строится
+        std::pmr::monotonic_buffer_resource buffer;
+        SearchServerOptions options;
+        options.memory_resource = &buffer;
+        SearchServer server("and", options);
+        server.AddDocument(1, texts[0], DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(server.FindTopDocuments("cat").size(), 1u);
+    }
+
+    // Тест проверяет хеш-таблицу слов: поиск, удаление, повторную вставку и неподвижность значений
+    void TestTermHashMap()
+    {
+        std::deque<std::string> words;
+        for (int i = 0; i < 5000; ++i)
+        {
+            words.push_back("word" + std::to_string(i));
+        }
+
+        TermHashMap<std::vector<int>> map;
+        std::vector<const std::vector<int>*> addresses;
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            const auto [it, is_inserted] = map.try_emplace(words[i], HashTerm(words[i]));
+            ASSERT(is_inserted);
+            it->second.push_back(static_cast<int>(i));
+            addresses.push_back(&it->second);
+        }
+        ASSERT_EQUAL(map.size(), words.size());
+        ASSERT(!map.try_emplace(words[7], HashTerm(words[7])).second);
+
+        // Значения не перемещаются при росте таблицы
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            const auto it = map.find(words[i]);
+            ASSERT(it != map.end());
+            ASSERT_EQUAL(&it->second, addresses[i]);
+            ASSERT_EQUAL(it->second[0], static_cast<int>(i));
+        }
+        ASSERT(map.find("word5000") == map.end());
+        ASSERT_EQUAL(map.count(""), 0u);
+
+        // Удаление каждого второго слова и вставка новых на их место
+        for (size_t i = 0; i < words.size(); i += 2)
+        {
+            map.erase(map.find(words[i]));
+        }
+        ASSERT_EQUAL(map.size(), words.size() / 2);
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            ASSERT_EQUAL(map.count(words[i]), i % 2);
+        }
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            words.push_back("new" + std::to_string(i));
+            map[words.back()].push_back(-1);
+        }
+        ASSERT_EQUAL(map.size(), words.size() / 2 + 1000 - 500);
+        ASSERT_EQUAL(map.at("new999")[0], -1);
+        ASSERT_EQUAL(map.at(words[1])[0], 1);
+
+        size_t iterated = 0;
+        for (const auto& [word, values] : map)
+        {
+            ASSERT(map.find(word)->second == values);
+            ++iterated;
+        }
+        ASSERT_EQUAL(iterated, map.size());
+
+        bool is_thrown = false;
+        try
+        {
+            map.at(words[0]);
+        }
+        catch (const std::out_of_range&)
+        {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+
+    // Тест проверяет множество стоп-слов с совершенным хешированием
+    void TestStopWordSet()
+    {
+        // Множество, построенное при компиляции
+        constexpr auto static_stop_words = MakeStopWordSet("a", "the", "and", "in", "on", "with", "the");
+        static_assert(static_stop_words.Contains("the"));
+        static_assert(static_stop_words.Contains("with"));
+        static_assert(!static_stop_words.Contains("then"));
+        static_assert(!static_stop_words.Contains(""));
+
+        // Множество, построенное при выполнении, с повторами и словами разной длины
+        std::vector<std::string> words;
+        for (int i = 0; i < 1000; ++i)
+        {
+            words.push_back("w" + std::to_string(i * 7));
+        }
+        words.push_back("w0");
+        words.push_back(std::string(100, 'x'));
+        const StopWordSet stop_words(words);
+        ASSERT_EQUAL(stop_words.GetWords().size(), 1001u);
+        for (const std::string& word : words)
+        {
+            ASSERT(stop_words.Contains(word));
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT(!stop_words.Contains("w" + std::to_string(i * 7 + 1)));
+        }
+        ASSERT(!stop_words.Contains(std::string(101, 'x')));
+        ASSERT(!stop_words.Contains(std::string(99, 'x')));
+        ASSERT(!StopWordSet().Contains("w0"));
+
+        // Большое множество строится за линейное время
+        std::vector<std::string> many_words;
+        for (int i = 0; i < 30000; ++i)
+        {
+            many_words.push_back("stop" + std::to_string(i * 3));
+        }
+        const StopWordSet many_stop_words(many_words);
+        ASSERT_EQUAL(many_stop_words.GetWords().size(), many_words.size());
+        for (int i = 0; i < 30000; ++i)
+        {
+            ASSERT(many_stop_words.Contains("stop" + std::to_string(i * 3)));
+            ASSERT(!many_stop_words.Contains("stop" + std::to_string(i * 3 + 2)));
+        }
+
+        // Сервер со стоп-словами при компиляции работает так же, как со стоп-словами из строки
+        SearchServer static_server(static_stop_words);
+        SearchServer server("a the and in on with");
+        for (SearchServer* search_server : {&static_server, &server})
+        {
+            search_server->AddDocument(1, "the cat in the city", DocumentStatus::ACTUAL, {1});
+            search_server->AddDocument(2, "a dog with the collar", DocumentStatus::ACTUAL, {2});
+        }
+        ASSERT(static_server.GetWordFrequencies(1) == server.GetWordFrequencies(1));
+        ASSERT(static_server.GetWordFrequencies(2) == server.GetWordFrequencies(2));
+        ASSERT(static_server.FindTopDocuments("the").empty());
+        ASSERT_EQUAL(static_server.FindTopDocuments("the cat").size(), 1u);
+    }
+
+    // Тест проверяет эквивалентность ранжирования при хранении частот слов во float и в 8 битах
+    void TestTermFreqPrecision()
+    {
+        const std::vector<std::string> vocabulary = {"cat", "dog", "bird", "fish", "cow", "owl", "fox", "bee", "ant", "elk"};
+        std::vector<std::string> texts;
+        for (int id = 0; id < 300; ++id)
+        {
+            std::string text;
+            const int length = 3 + (id * 7) % 17;
+            for (int i = 0; i < length; ++i)
+            {
+                text += vocabulary[(id * 3 + i * i + i * id / 5) % vocabulary.size()] + " ";
+            }
+            texts.push_back(text);
+        }
+
+        std::vector<std::unique_ptr<SearchServer>> servers;
+        for (const TermFreqPrecision precision : {TermFreqPrecision::DOUBLE, TermFreqPrecision::FLOAT, TermFreqPrecision::UINT8})
+        {
+            SearchServerOptions options;
+            options.term_freq_precision = precision;
+            servers.push_back(std::make_unique<SearchServer>("", options));
+            for (int id = 0; id < static_cast<int>(texts.size()); ++id)
+            {
+                servers.back()->AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id % 13});
+            }
+            servers.back()->RemoveDocument(10);
+        }
+        const SearchServer& exact_server = *servers[0];
+        const SearchServer& float_server = *servers[1];
+        const SearchServer& uint8_server = *servers[2];
+
+        // Частоты в 8 битах занимают меньше памяти
+        ASSERT(float_server.GetMemoryStats().postings < exact_server.GetMemoryStats().postings);
+        ASSERT(uint8_server.GetMemoryStats().postings < float_server.GetMemoryStats().postings);
+
+        // Чтение блоками и через Visit дает те же частоты, что и чтение по индексу
+        for (const TermFreqPrecision precision : {TermFreqPrecision::DOUBLE, TermFreqPrecision::FLOAT, TermFreqPrecision::UINT8})
+        {
+            TermFreqColumn column(precision);
+            for (int i = 0; i < 200; ++i)
+            {
+                column.push_back(1.0 / (1 + i % 37));
+            }
+            TermFreqBlockReader reader(column, column.size());
+            column.Visit([&column, &reader](auto read_term_freq)
+                {
+                    for (size_t i = 3; i < column.size(); i += 1 + i % 3)
+                    {
+                        ASSERT_EQUAL(read_term_freq(i), column[i]);
+                        ASSERT_EQUAL(reader[i], column[i]);
+                    }
+                });
+        }
+
+        const std::vector<std::string> queries = {"cat", "dog bird", "fish -cow", "owl fox bee", "ant elk cat dog"};
+        for (const std::string& query : queries)
+        {
+            // float: те же документы в том же порядке, релевантность совпадает с точностью 1e-6
+            for (const bool use_bm25 : {false, true})
+            {
+                const auto expected = use_bm25 ? exact_server.FindTopDocuments<Bm25Scorer>(std::execution::seq, query)
+                    : exact_server.FindTopDocuments(query);
+                const auto documents = use_bm25 ? float_server.FindTopDocuments<Bm25Scorer>(std::execution::seq, query)
+                    : float_server.FindTopDocuments(query);
+                ASSERT_EQUAL(documents.size(), expected.size());
+                for (size_t i = 0; i < documents.size(); ++i)
+                {
+                    ASSERT_EQUAL(documents[i].id, expected[i].id);
+                    ASSERT(std::abs(documents[i].relevance - expected[i].relevance) < 1e-6);
+                }
+            }
+
+            // 8 бит: частота отличается от точной не больше чем на шаг квантования (2 / 255 для частот до 1),
+            // поэтому релевантность отличается не больше чем на сумму IDF слов, умноженную на шаг
+            const double word_count = std::count(query.begin(), query.end(), ' ') + 1.0;
+            const double max_idf = std::log(static_cast<double>(exact_server.GetDocumentCount()));
+            const double bound = word_count * max_idf * 2.0 / 255.0;
+            const auto expected = exact_server.FindTopDocuments(query);
+            const auto documents = uint8_server.FindTopDocuments(query);
+            ASSERT_EQUAL(documents.size(), expected.size());
+            for (const Document& document : documents)
+            {
+                const auto exact = exact_server.FindTopDocuments(query,
+                    [&document](int document_id, DocumentStatus, int)
+                    {
+                        return document_id == document.id;
+                    });
+                ASSERT_EQUAL(exact.size(), 1u);
+                ASSERT(std::abs(exact[0].relevance - document.relevance) <= bound);
+
+                // Документ из квантованного результата не может быть заметно хуже последнего точного результата
+                ASSERT(exact[0].relevance >= expected.back().relevance - 2.0 * bound);
+            }
+        }
+    }
+
+    // Тест проверяет, что уплотнение внутренних номеров документов не меняет результаты
+    void TestCompaction()
+    {
+        const std::vector<std::string> vocabulary = {"white", "cat", "fluffy", "tail", "dog", "collar", "bird", "eyes"};
+        const std::vector<std::string> queries = {"white cat", "fluffy -dog", "+cat tail", "\"white cat\"", "col*", "colar~", "bird eyes dog"};
+        for (const ForwardIndexMode mode : {ForwardIndexMode::FULL, ForwardIndexMode::COMPACT})
+        {
+            SearchServerOptions options;
+            options.forward_index = mode;
+            options.impact_order_min_postings = 1;
+            SearchServer server("and", options);
+            for (int id = 0; id < 120; ++id)
+            {
+                std::string text;
+                for (int i = 0; i < 3 + id % 5; ++i)
+                {
+                    text += vocabulary[(id * 5 + i * 3 + i * i) % vocabulary.size()] + " ";
+                }
+                server.AddDocument(id, text, static_cast<DocumentStatus>(id % 2), {id % 7});
+            }
+            for (int id = 0; id < 120; id += 3)
+            {
+                server.RemoveDocument(id);
+            }
+            server.AddDocument(0, "white cat with a fluffy tail", DocumentStatus::ACTUAL, {5});
+
+            const auto collect = [&server, &queries]()
+            {
+                std::vector<std::vector<Document>> results;
+                for (const std::string& query : queries)
+                {
+                    results.push_back(server.FindTopDocuments(query));
+                    results.push_back(server.FindTopDocuments(query, DocumentStatus::IRRELEVANT));
+                }
+                return results;
+            };
+            const auto expected = collect();
+            const std::map<std::string_view, double> expected_freqs = server.GetWordFrequencies(4);
+            const auto expected_match = server.MatchDocument("fluffy cat -dog", 4);
+            const size_t metadata_before = server.GetMemoryStats().metadata;
+
+            server.Compact();
+            ASSERT(server.GetMemoryStats().metadata < metadata_before);
+            const auto results = collect();
+            ASSERT_EQUAL(results.size(), expected.size());
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                ASSERT_EQUAL(results[i].size(), expected[i].size());
+                for (size_t j = 0; j < results[i].size(); ++j)
+                {
+                    ASSERT_EQUAL(results[i][j].id, expected[i][j].id);
+                    ASSERT(std::abs(results[i][j].relevance - expected[i][j].relevance) < 1e-6);
+                }
+            }
+            ASSERT(server.GetWordFrequencies(4) == expected_freqs);
+            ASSERT(server.MatchDocument("fluffy cat -dog", 4) == expected_match);
+            ASSERT_EQUAL(server.GetDocumentCount(), 81);
+
+            // После уплотнения документы добавляются и удаляются как обычно
+            server.AddDocument(500, "fluffy fluffy bird", DocumentStatus::ACTUAL, {1});
+            ASSERT_EQUAL(server.FindTopDocuments("fluffy bird")[0].id, 500);
+            server.RemoveDocument(500);
+            server.RemoveDocument(0);
+            ASSERT_EQUAL(server.GetDocumentCount(), 80);
+        }
+
+        // Автоматическое уплотнение при удалении
+        SearchServerOptions options;
+        options.compaction_removed_share = 0.25;
+        SearchServer server("", options);
+        for (int id = 0; id < 40; ++id)
+        {
+            server.AddDocument(id, id % 2 == 0 ? "even number" : "odd number", DocumentStatus::ACTUAL, {id});
+        }
+        for (int id = 0; id < 40; id += 2)
+        {
+            server.RemoveDocument(id);
+        }
+        const auto documents = server.FindTopDocuments("odd", [](int, DocumentStatus, int) { return true; });
+        ASSERT_EQUAL(documents.size(), 5u);
+        ASSERT_EQUAL(documents[0].id, 39);
+        ASSERT(server.FindTopDocuments("even").empty());
+        ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()).size(), 20u);
+    }
+
+    void TestSegmentedIndex()
+    {
+        const std::vector<std::string> vocabulary = {"white", "cat", "fluffy", "tail", "dog", "collar", "bird", "eyes", "and"};
+        const std::vector<std::string> queries = {"white cat", "fluffy -dog", "cat tail -eyes", "bird eyes dog and", "collar"};
+        const auto make_text = [&vocabulary](int id)
+        {
+            std::string text = vocabulary[id % vocabulary.size()];
+            for (int i = 1; i < 3 + id % 5; ++i)
+            {
+                text += " " + vocabulary[(id * 5 + i * 3 + i * i) % vocabulary.size()];
+            }
+            return text;
+        };
+        const auto check_equal = [&queries](const SegmentedSearchServer& segmented, const SearchServer& server)
+        {
+            ASSERT_EQUAL(segmented.GetDocumentCount(), server.GetDocumentCount());
+            for (const std::string& query : queries)
+            {
+                for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT})
+                {
+                    const auto documents = segmented.FindTopDocuments(query, status);
+                    const auto expected = server.FindTopDocuments(query, status);
+                    ASSERT_EQUAL(documents.size(), expected.size());
+                    for (size_t i = 0; i < documents.size(); ++i)
+                    {
+                        ASSERT(std::abs(documents[i].relevance - expected[i].relevance) < 1e-6);
+                        ASSERT_EQUAL(documents[i].rating, expected[i].rating);
+                    }
+                }
+            }
+        };
+
+        SegmentedIndexOptions options;
+        options.seal_document_count = 8;
+        options.merge_factor = 2;
+        SegmentedSearchServer segmented("and", options);
+        SearchServer server("and");
+        for (int id = 0; id < 150; ++id)
+        {
+            segmented.AddDocument(id, make_text(id), static_cast<DocumentStatus>(id % 2), {id % 7, id % 3});
+            server.AddDocument(id, make_text(id), static_cast<DocumentStatus>(id % 2), {id % 7, id % 3});
+        }
+
+        // Без удалений сегменты дают ту же релевантность, что и единый индекс
+        segmented.WaitForMerges();
+        ASSERT(segmented.GetSegmentCount() < 150u / 8u);
+        check_equal(segmented, server);
+        for (const auto& make_invalid_call : std::vector<std::function<void()>>{
+            [&segmented]() { segmented.AddDocument(3, "cat", DocumentStatus::ACTUAL, {1}); },
+            [&segmented]() { segmented.FindTopDocuments("cat --dog"); }})
+        {
+            try
+            {
+                make_invalid_call();
+                ASSERT_HINT(false, "Invalid call must throw");
+            }
+            catch (const std::invalid_argument&)
+            {
+            }
+        }
+
+        // Удалённые документы не попадают в результаты ни из памяти, ни из запечатанных сегментов
+        for (int id = 0; id < 150; id += 4)
+        {
+            segmented.RemoveDocument(id);
+            server.RemoveDocument(id);
+        }
+        segmented.RemoveDocument(1000);
+        ASSERT_EQUAL(segmented.GetDocumentCount(), server.GetDocumentCount());
+        for (const std::string& query : queries)
+        {
+            for (const Document& document : segmented.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }))
+            {
+                ASSERT(document.id % 4 != 0);
+            }
+        }
+
+        // После полного слияния статистика не учитывает удалённые документы
+        segmented.ForceMerge();
+        ASSERT_EQUAL(segmented.GetSegmentCount(), 1u);
+        check_equal(segmented, server);
+
+        // Удалённый id можно добавить снова
+        segmented.AddDocument(0, "fluffy fluffy bird", DocumentStatus::ACTUAL, {9});
+        ASSERT_EQUAL(segmented.FindTopDocuments("fluffy bird")[0].id, 0);
+
+        // Запросы и изменения из разных потоков во время слияний
+        std::thread writer([&segmented]()
+            {
+                for (int id = 1000; id < 1200; ++id)
+                {
+                    segmented.AddDocument(id, "white bird with collar", DocumentStatus::ACTUAL, {1});
+                    if (id % 3 == 0)
+                    {
+                        segmented.RemoveDocument(id - 1);
+                    }
+                }
+            });
+        for (int i = 0; i < 200; ++i)
+        {
+            for (const Document& document : segmented.FindTopDocuments("white collar"))
+            {
+                ASSERT(document.id % 4 != 0 || document.id >= 1000);
+            }
+        }
+        writer.join();
+        segmented.ForceMerge();
+        ASSERT_EQUAL(segmented.GetDocumentCount(), server.GetDocumentCount() + 1 + 200 - 66);
+    }
+
+    void TestQueryPlanner()
+    {
+        // Слово "the" есть в каждом документе, поэтому его IDF равен нулю
+        SearchServer server("and");
+        for (int id = 0; id < 40; ++id)
+        {
+            std::string text = "the";
+            text += id % 2 == 0 ? " cat" : " dog";
+            text += id % 5 == 0 ? " fluffy tail" : " collar";
+            text += id == 7 ? " bird" : "";
+            server.AddDocument(id, text, static_cast<DocumentStatus>(id % 3 == 0), {id});
+        }
+
+        const QueryPlanInfo cat_plan = server.Explain("the cat fluffy");
+        ASSERT(cat_plan.plus_strategy == PlusStrategy::DOCUMENT_AT_A_TIME);
+        ASSERT(cat_plan.minus_strategy == MinusStrategy::NONE);
+        ASSERT_EQUAL(cat_plan.plus_terms.size(), 3u);
+        for (const PlannedTerm& term : cat_plan.plus_terms)
+        {
+            ASSERT_EQUAL(term.is_dropped, term.word == "the");
+        }
+        ASSERT_EQUAL(cat_plan.plus_terms[2].document_freq, 40u);
+        ASSERT(cat_plan.GetEstimatedCost() > 0.0);
+        std::ostringstream plan_text;
+        plan_text << cat_plan;
+        ASSERT(plan_text.str().find("document_at_a_time") != std::string::npos);
+
+        ASSERT(server.Explain("fluffy").plus_strategy == PlusStrategy::TERM_AT_A_TIME);
+        ASSERT(server.Explain("+cat tail").plus_strategy == PlusStrategy::INTERSECTION);
+        ASSERT(server.Explain("cat dog col*").plus_strategy == PlusStrategy::TERM_AT_A_TIME);
+        ASSERT(server.Explain("cat -collar").minus_strategy == MinusStrategy::MINUS_FIRST);
+        ASSERT(server.Explain("bird -the").minus_strategy == MinusStrategy::MINUS_PROBE);
+
+        // Результаты совпадают с параллельным поиском, который всегда идёт по словам
+        const std::vector<std::string> queries = {"the", "the cat fluffy", "cat dog tail", "bird -the", "fluffy -cat", "+cat tail the",
+            "the -cat", "the col*"};
+        for (const std::string& query : queries)
+        {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT})
+            {
+                const auto documents = server.FindTopDocuments(query, status);
+                const auto expected = server.FindTopDocuments(std::execution::par, query, status);
+                ASSERT_EQUAL(documents.size(), expected.size());
+                for (size_t i = 0; i < documents.size(); ++i)
+                {
+                    ASSERT_EQUAL(documents[i].id, expected[i].id);
+                    ASSERT_EQUAL(documents[i].relevance, expected[i].relevance);
+                }
+            }
+        }
+
+        // Документы только со словами нулевого веса находятся с нулевой релевантностью
+        const auto the_documents = server.FindTopDocuments("the");
+        ASSERT_EQUAL(the_documents.size(), 5u);
+        for (const Document& document : the_documents)
+        {
+            ASSERT_EQUAL(document.relevance, 0.0);
+        }
+        ASSERT_EQUAL(server.FindResults("the cat", DocumentStatus::ACTUAL).size(), 26u);
+        ASSERT_EQUAL(server.FindResults("the -cat", DocumentStatus::ACTUAL).size(), 13u);
+        for (const Document& document : server.FindTopDocuments("the cat"))
+        {
+            ASSERT(document.relevance > 0.0);
+        }
+    }
+
+    void TestSortKeys()
+    {
+        // Ключ монотонен по релевантности, при разнице меньше 1e-6 решает рейтинг
+        ASSERT(GetSortKey({1, 0.5, 1}) > GetSortKey({2, 0.4, 100}));
+        ASSERT(GetSortKey({1, 0.5, 2}) > GetSortKey({2, 0.5 + 1e-8, 1}));
+        ASSERT(GetSortKey({1, 0.0, -5}) > GetSortKey({2, 0.0, -6}));
+        ASSERT(GetSortKey({1, 1e-5, 0}) > GetSortKey({2, 0.0, 1000}));
+        ASSERT(GetSortKey({1, 1e9, 0}) == GetSortKey({2, 1e10, 0}));
+
+        // Выбор лучших документов совпадает с сортировкой по ключу, равные ключи сохраняют порядок
+        std::vector<Document> documents;
+        for (int id = 0; id < 3000; ++id)
+        {
+            documents.push_back({id, (id * 7919 % 1000) / 100.0 + (id % 3) * 1e-8, id % 11 - 5});
+        }
+        for (const size_t count : {size_t{0}, size_t{1}, size_t{5}, size_t{100}, size_t{5000}})
+        {
+            std::vector<Document> expected = documents;
+            std::stable_sort(expected.begin(), expected.end(), IsMoreRelevant);
+            expected.resize(std::min(count, expected.size()));
+            std::vector<Document> top = documents;
+            KeepTopDocuments(top, count);
+            ASSERT_EQUAL(top.size(), expected.size());
+            for (size_t i = 0; i < top.size(); ++i)
+            {
+                ASSERT_EQUAL(top[i].id, expected[i].id);
+            }
+        }
+
+        // Нулевая и отрицательная релевантность округляются к нулю, тогда решает рейтинг
+        {
+            std::vector<Document> top = {{1, 0.0, 1}, {2, 0.0, 2}, {3, -0.5, 9}, {4, -2.0, 3}};
+            KeepTopDocuments(top, 2);
+            ASSERT_EQUAL(top.size(), 2u);
+            ASSERT_EQUAL(top[0].id, 3);
+            ASSERT_EQUAL(top[1].id, 4);
+        }
+
+        // Порядок в пределах точности совпадает с прежним сравнением по модулю разности
+        for (size_t i = 1; i < 200; ++i)
+        {
+            const Document& lhs = documents[i - 1];
+            const Document& rhs = documents[i];
+            if (std::abs(lhs.relevance - rhs.relevance) >= 1e-6)
+            {
+                ASSERT_EQUAL(IsMoreRelevant(lhs, rhs), lhs.relevance > rhs.relevance);
+            }
+        }
+    }
+
+    void TestBatchRemoval()
+    {
+        const std::vector<std::string> vocabulary = {"white", "cat", "fluffy", "tail", "dog", "collar", "bird", "eyes"};
+        const std::vector<std::string> queries = {"white cat", "fluffy -dog", "+cat tail", "\"white cat\"", "col*", "bird eyes dog", "parrot"};
+        for (const ForwardIndexMode mode : {ForwardIndexMode::FULL, ForwardIndexMode::COMPACT, ForwardIndexMode::NONE})
+        {
+            SearchServerOptions options;
+            options.forward_index = mode;
+            options.impact_order_min_postings = 1;
+            SearchServer one_by_one("and", options);
+            SearchServer batch("and", options);
+            for (int id = 0; id < 150; ++id)
+            {
+                std::string text;
+                for (int i = 0; i < 3 + id % 5; ++i)
+                {
+                    text += vocabulary[(id * 5 + i * 3 + i * i) % vocabulary.size()] + " ";
+                }
+                // Слово parrot есть только в удаляемых документах
+                if (id % 30 == 0)
+                {
+                    text += "parrot";
+                }
+                for (SearchServer* server : {&one_by_one, &batch})
+                {
+                    server->AddDocument(id, text, static_cast<DocumentStatus>(id % 2), {id % 7});
+                }
+            }
+            ASSERT(!batch.FindTopDocuments("parrot").empty());
+
+            // Неизвестные и повторяющиеся id пропускаются
+            std::vector<int> removed_ids = {1000, -1};
+            for (int id = 0; id < 150; id += 3)
+            {
+                removed_ids.push_back(id);
+                one_by_one.RemoveDocument(id);
+            }
+            removed_ids.push_back(3);
+            const uint64_t version = batch.GetIndexVersion();
+            batch.RemoveDocuments(std::execution::par, removed_ids);
+            ASSERT_EQUAL(batch.GetIndexVersion(), version + 1);
+            ASSERT_EQUAL(batch.GetDocumentCount(), 100);
+            ASSERT_EQUAL(batch.GetDocumentCount(), one_by_one.GetDocumentCount());
+            ASSERT(std::equal(batch.begin(), batch.end(), one_by_one.begin(), one_by_one.end()));
+
+            // Результаты совпадают с поочерёдным удалением, включая фразы и IDF
+            for (const std::string& query : queries)
+            {
+                for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT})
+                {
+                    const std::vector<Document> expected = one_by_one.FindTopDocuments(query, status);
+                    const std::vector<Document> results = batch.FindTopDocuments(query, status);
+                    ASSERT_EQUAL(results.size(), expected.size());
+                    for (size_t i = 0; i < results.size(); ++i)
+                    {
+                        ASSERT_EQUAL(results[i].id, expected[i].id);
+                        ASSERT(std::abs(results[i].relevance - expected[i].relevance) < 1e-6);
+                    }
+                }
+            }
+            ASSERT(batch.FindTopDocuments("parrot").empty());
+            ASSERT(batch.MatchDocument("fluffy cat -dog", 4) == one_by_one.MatchDocument("fluffy cat -dog", 4));
+            const std::map<std::string_view, double> expected_freqs = one_by_one.GetWordFrequencies(4);
+            ASSERT(batch.GetWordFrequencies(4) == expected_freqs);
+            ASSERT(batch.GetWordFrequencies(3).empty());
+
+            // Последовательная версия и удаление всех оставшихся документов
+            batch.RemoveDocuments(std::execution::seq, {4});
+            batch.RemoveDocuments(std::vector<int>(batch.begin(), batch.end()));
+            ASSERT_EQUAL(batch.GetDocumentCount(), 0);
+            ASSERT(batch.FindTopDocuments("white cat").empty());
+            batch.AddDocument(4, "fluffy white cat", DocumentStatus::ACTUAL, {1});
+            ASSERT_EQUAL(batch.FindTopDocuments("\"white cat\"")[0].id, 4);
+        }
+
+        // Уплотнение запускается один раз после удаления всей пачки
+        SearchServerOptions options;
+        options.compaction_removed_share = 0.25;
+        SearchServer server("", options);
+        std::vector<int> removed_ids;
+        for (int id = 0; id < 40; ++id)
+        {
+            server.AddDocument(id, id % 2 == 0 ? "even number" : "odd number", DocumentStatus::ACTUAL, {id});
+            if (id % 2 == 0)
+            {
+                removed_ids.push_back(id);
+            }
+        }
+        server.RemoveDocuments(removed_ids);
+        ASSERT_EQUAL(server.GetDocumentCount(), 20);
+        ASSERT_EQUAL(server.FindTopDocuments("odd").size(), 5u);
+        ASSERT(server.FindTopDocuments("even").empty());
+    }
+
     // Функция TestSearchServer является точкой входа для запуска тестов
     void TestSearchServer() {
         RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
@@ -341,6 +1956,30 @@ namespace Test_SearchServer
         RUN_TEST(TestFoundDocumentSortedByRelevance);
         RUN_TEST(TestRatingOfTheDocument);
         RUN_TEST(TestFindDocumentByStatus);
+        RUN_TEST(TestPhraseQueries);
+        RUN_TEST(TestPrefixQueries);
+        RUN_TEST(TestFuzzyQueries);
+        RUN_TEST(TestScoringPolicies);
+        RUN_TEST(TestDocumentFilter);
+        RUN_TEST(TestRoaringBitmap);
+        RUN_TEST(TestRequiredWords);
+        RUN_TEST(TestResultPages);
+        RUN_TEST(TestRequestQueue);
+        RUN_TEST(TestQueryMetrics);
+        RUN_TEST(TestQueryBatch);
+        RUN_TEST(TestAsyncQueries);
+        RUN_TEST(TestImpactOrderedPostings);
+        RUN_TEST(TestMatchDocuments);
+        RUN_TEST(TestForwardIndexModes);
+        RUN_TEST(TestMemoryResource);
+        RUN_TEST(TestTermHashMap);
+        RUN_TEST(TestStopWordSet);
+        RUN_TEST(TestTermFreqPrecision);
+        RUN_TEST(TestCompaction);
+        RUN_TEST(TestSegmentedIndex);
+        RUN_TEST(TestQueryPlanner);
+        RUN_TEST(TestSortKeys);
+        RUN_TEST(TestBatchRemoval);
     }
 
     // --------- Окончание модульных тестов поисковой системы -----------
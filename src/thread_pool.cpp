@@ -0,0 +1,200 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Pool and index of the worker running on the current thread
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+}
+
+// ------------------------------- Constructors ------------------------------- //
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        workers_[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard guard(sleep_mutex_);
+        is_stopped_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+
+// ------------------------------- Interface (public) ------------------------------- //
+
+void ThreadPool::Submit(TaskGroup& group, std::function<void()> task)
+{
+    group.remaining_.fetch_add(1, std::memory_order_relaxed);
+    Push({std::move(task), &group});
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    Push({std::move(task), nullptr});
+}
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+    const size_t index = current_pool == this ? current_worker : 0;
+    Task task;
+    while (!group.IsDone())
+    {
+        if (TryTakeTask(index, task))
+        {
+            Run(task);
+            continue;
+        }
+
+        // Other threads run the tasks of the group, Run wakes all sleeping threads when a group is done
+        std::unique_lock lock(sleep_mutex_);
+        wake_.wait(lock, [this, &group]()
+            {
+                return group.IsDone() || pending_.load(std::memory_order_acquire) > 0;
+            });
+    }
+
+    // The wakeup of a submitted task may have come to this thread, then it is passed to a worker
+    if (pending_.load(std::memory_order_acquire) > 0)
+    {
+        wake_.notify_one();
+    }
+
+    if (group.exception_)
+    {
+        // The group can be used again
+        std::exception_ptr exception = std::move(group.exception_);
+        group.exception_ = nullptr;
+        group.has_exception_.clear();
+        std::rethrow_exception(exception);
+    }
+}
+
+
+// ------------------------------- Private ------------------------------- //
+
+void ThreadPool::Push(Task task)
+{
+    // Workers keep their tasks, other threads spread tasks over workers
+    const size_t index = current_pool == this
+        ? current_worker
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    // The task is counted before it can be taken, so the counter never goes below zero
+    {
+        std::lock_guard guard(sleep_mutex_);
+        pending_.fetch_add(1, std::memory_order_release);
+    }
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard guard(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+
+    Task task;
+    while (true)
+    {
+        if (TryTakeTask(index, task))
+        {
+            Run(task);
+            continue;
+        }
+
+        std::unique_lock lock(sleep_mutex_);
+        wake_.wait(lock, [this]()
+            {
+                return is_stopped_ || pending_.load(std::memory_order_acquire) > 0;
+            });
+        // Tasks left at the stop are finished
+        if (is_stopped_ && pending_.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryTakeTask(size_t index, Task& task)
+{
+    // Own tasks are taken from the back: the latest subtasks are hot in cache
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard guard(worker.mutex);
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Tasks of others are stolen from the front: the oldest tasks are the biggest ones
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard guard(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Run(Task& task)
+{
+    // An exception must not leave the worker, and the task is counted as finished anyway
+    try
+    {
+        task.function();
+    }
+    catch (...)
+    {
+        if (task.group && !task.group->has_exception_.test_and_set(std::memory_order_relaxed))
+        {
+            task.group->exception_ = std::current_exception();
+        }
+    }
+    task.function = nullptr;
+    if (task.group && task.group->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // The group may be destroyed by its waiter right after the decrement, so it is not touched any more
+        // The lock orders the notification after the check of a thread going to sleep
+        {
+            std::lock_guard guard(sleep_mutex_);
+        }
+        wake_.notify_all();
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// ThreadPool - pool of worker threads with work stealing
+// Every worker has its own deque of tasks: it takes tasks from the back of its deque
+// and steals from the front of deques of other workers when its deque is empty.
+// Tasks submitted by a worker go to its own deque, so subtasks of a task stay on the same thread unless others are idle.
+// A thread waiting for a TaskGroup runs tasks of the pool meanwhile, so tasks may wait for their subtasks.
+// When there is nothing to run it sleeps until a task is submitted or the last task of the group is finished
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // Tasks to wait for together
+    class TaskGroup
+    {
+    public:
+        bool IsDone() const
+        {
+            return remaining_.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class ThreadPool;
+        std::atomic<size_t> remaining_{0};
+
+        // The first exception of the tasks, rethrown by Wait. Set before the task is counted as finished
+        std::atomic_flag has_exception_ = ATOMIC_FLAG_INIT;
+        std::exception_ptr exception_;
+    };
+
+    // thread_count = 0 - one thread per hardware thread
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const
+    {
+        return workers_.size();
+    }
+
+    void Submit(TaskGroup& group, std::function<void()> task);
+
+    // Submit a task nobody waits for. Such tasks are finished before the pool is destroyed
+    // Exceptions of such tasks are dropped, the task must report errors itself (e.g. by a promise)
+    void Submit(std::function<void()> task);
+
+    // Wait for all tasks of the group, running tasks of the pool meanwhile
+    // If tasks of the group threw, the first exception is rethrown after all of them are finished
+    void Wait(TaskGroup& group);
+
+    // Call function(i) for every i in [0, count) as separate tasks and wait for them
+    template <typename Function>
+    void ParallelFor(size_t count, Function function)
+    {
+        TaskGroup group;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Submit(group, [&function, i]()
+                {
+                    function(i);
+                });
+        }
+        Wait(group);
+    }
+
+private:
+    struct Task
+    {
+        std::function<void()> function;
+        TaskGroup* group;       // nullptr for a detached task
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void WorkerLoop(size_t index);
+
+    void Push(Task task);
+
+    // Take a task from the deque of the worker (or of the next worker for other threads) or steal it
+    bool TryTakeTask(size_t index, Task& task);
+
+    void Run(Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // Amount of tasks in all deques, workers and waiting threads sleep while it is zero
+    std::atomic<size_t> pending_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool is_stopped_ = false;
+
+    // Next deque for tasks submitted from threads outside of the pool
+    std::atomic<size_t> next_worker_{0};
+};